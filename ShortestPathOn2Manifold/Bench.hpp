@@ -0,0 +1,655 @@
+#pragma once
+#include "mesh/MeshBuilder.hpp"
+#include "mesh/MeshBVH.hpp"
+#include "Camera.hpp"
+#include "geodesic/BatchQuery.hpp"
+#include "geodesic/SingleSourceQuery.hpp"
+#include "geodesic/SourceTreeCache.hpp"
+#include "geodesic/DeltaStepping.hpp"
+#include "geodesic/ExactGeodesic.hpp"
+#include "geodesic/HeatGeodesic.hpp"
+#include "geodesic/FastMarching.hpp"
+#include <chrono>
+#include <string.h>
+// Headless benchmarks, run with --bench instead of opening a window.
+// Synthetic meshes are tori, whose inner ring gives plenty of saddle vertices.
+// Every benchmark also checks its results and returns the number of failed checks, --bench exits
+// with 1 if any failed so it can gate CI.
+struct Bench
+{
+	static void makeTorus( uint32_t rings , uint32_t sides , float majorRadius , float minorRadius ,
+		std::vector< float3 > &positions , std::vector< uint32_t > &indices )
+	{
+		positions.clear();
+		indices.clear();
+		for( uint32_t i = 0; i < rings; i++ )
+		{
+			float phi = 2.0f * MathUtil< float >::PI * i / rings;
+			for( uint32_t j = 0; j < sides; j++ )
+			{
+				float theta = 2.0f * MathUtil< float >::PI * j / sides;
+				float radius = majorRadius + minorRadius * cosf( theta );
+				positions.push_back( { radius * cosf( phi ) , radius * sinf( phi ) , minorRadius * sinf( theta ) } );
+			}
+		}
+		for( uint32_t i = 0; i < rings; i++ )
+		{
+			for( uint32_t j = 0; j < sides; j++ )
+			{
+				uint32_t a = i * sides + j;
+				uint32_t b = ( ( i + 1 ) % rings ) * sides + j;
+				uint32_t c = ( ( i + 1 ) % rings ) * sides + ( j + 1 ) % sides;
+				uint32_t d = i * sides + ( j + 1 ) % sides;
+				indices.insert( indices.end() , { a , b , c , a , c , d } );
+			}
+		}
+	}
+	static bool loadObj( Mesh &mesh , char const *path )
+	{
+		tinyobj::attrib_t attrib;
+		std::vector< tinyobj::shape_t > shapes;
+		std::vector< tinyobj::material_t > materials;
+		std::string err;
+		if( !tinyobj::LoadObj( &attrib , &shapes , &materials , &err , path , "" , true ) || shapes.empty() )
+		{
+			printf( "Failed to load %s\n" , path );
+			return false;
+		}
+		MeshBuildStats buildStats;
+		return MeshBuilder::build( mesh , attrib , shapes[ 0 ].mesh.indices , buildStats );
+	}
+	// Dual graph A* against exact window propagation between the same random face centers. Dual paths
+	// run through edge midpoints on the surface, so one shorter than the exact geodesic is a failure.
+	static uint32_t exactVsApprox( Mesh const &mesh , char const *name , uint32_t queryCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		FaceSearch faceSearch;
+		ExactGeodesic exactGeodesic;
+		double approxSeconds = 0.0 , exactSeconds = 0.0 , sumError = 0.0 , maxError = 0.0;
+		uint32_t windowCount = 0 , failures = 0;
+		srand( 1 );
+		for( uint32_t i = 0; i < queryCount; i++ )
+		{
+			SearchEndpoints endpoints;
+			endpoints.sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.sourcePoint = graph.aFaceCenter[ endpoints.sourceFace ];
+			endpoints.targetPoint = graph.aFaceCenter[ endpoints.targetFace ];
+			auto start = std::chrono::high_resolution_clock::now();
+			faceSearch.run( graph , endpoints , false );
+			approxSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			exactGeodesic.run( mesh , endpoints.sourceFace , endpoints.sourcePoint , endpoints.targetFace , endpoints.targetPoint );
+			exactSeconds += exactGeodesic.stats.seconds;
+			windowCount += exactGeodesic.stats.windowsCreated;
+			double exact = exactGeodesic.getDistance( endpoints.targetFace , endpoints.targetPoint );
+			if( exact > 0.0 )
+			{
+				double error = ( faceSearch.getDistance( endpoints.targetFace ) - exact ) / exact;
+				sumError += error;
+				maxError = error > maxError ? error : maxError;
+				failures += error < -1.0e-4;
+			}
+		}
+		printf( "%-16s %8u faces  A* %8.3f ms  exact %9.3f ms  %9u windows  approx error mean %5.2f%% max %5.2f%%  %u failures\n" ,
+			name , mesh.getFaceCount() , approxSeconds * 1000.0 / queryCount , exactSeconds * 1000.0 / queryCount ,
+			windowCount / queryCount , sumError * 100.0 / queryCount , maxError * 100.0 , failures );
+		return failures;
+	}
+	// Heat method and Fast Marching distance fields against full exact propagation from the same face
+	// centers. Both are approximations, a mean error above HEAT_TOLERANCE or MARCH_TOLERANCE fails.
+	static uint32_t fieldsVsExact( Mesh const &mesh , char const *name , uint32_t sourceCount )
+	{
+		double const HEAT_TOLERANCE = 0.10 , MARCH_TOLERANCE = 0.10;
+		HeatGeodesic heatGeodesic;
+		heatGeodesic.update( mesh );
+		if( !heatGeodesic.factored )
+		{
+			printf( "%-16s factorization failed\n" , name );
+			return 1;
+		}
+		FastMarching fastMarching;
+		ExactGeodesic exactGeodesic;
+		double heatSeconds = 0.0 , marchSeconds = 0.0 , exactSeconds = 0.0;
+		double heatError = 0.0 , marchError = 0.0 , sumDist = 0.0;
+		srand( 2 );
+		for( uint32_t i = 0; i < sourceCount; i++ )
+		{
+			uint32_t face = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			float3 point = mesh.getFaceCenter( face );
+			heatGeodesic.run( mesh , face , point );
+			heatSeconds += heatGeodesic.stats.solveSeconds;
+			fastMarching.run( mesh , face , point );
+			marchSeconds += fastMarching.stats.seconds;
+			exactGeodesic.run( mesh , face , point );
+			exactSeconds += exactGeodesic.stats.seconds;
+			for( uint32_t vertex = 0; vertex < mesh.getVertexCount(); vertex++ )
+			{
+				double exact = exactGeodesic.getVertexDistance( vertex );
+				if( exact != DBL_MAX )
+				{
+					heatError += fabs( heatGeodesic.getVertexDistance( vertex ) - exact );
+					marchError += fabs( fastMarching.getVertexDistance( vertex ) - exact );
+					sumDist += exact;
+				}
+			}
+		}
+		sumDist = sumDist > 0.0 ? sumDist : 1.0;
+		uint32_t failures = ( heatError / sumDist > HEAT_TOLERANCE ) + ( marchError / sumDist > MARCH_TOLERANCE );
+		printf( "%-16s %8u verts  exact %9.3f ms  heat %8.3f ms error %5.2f%% (factor %9.3f ms, %u nnz)  fmm %8.3f ms error %5.2f%%  %u failures\n" ,
+			name , mesh.getVertexCount() , exactSeconds * 1000.0 / sourceCount ,
+			heatSeconds * 1000.0 / sourceCount , heatError * 100.0 / sumDist , heatGeodesic.stats.buildSeconds * 1000.0 ,
+			heatGeodesic.stats.heatNonZeros + heatGeodesic.stats.poissonNonZeros ,
+			marchSeconds * 1000.0 / sourceCount , marchError * 100.0 / sumDist , failures );
+		return failures;
+	}
+	// Batch A* path queries on pools of growing size, checked against a single context answering them in order
+	static uint32_t batchQueries( Mesh const &mesh , char const *name , uint32_t queryCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		std::vector< SearchEndpoints > aQueries( queryCount );
+		srand( 3 );
+		for( auto &endpoints : aQueries )
+		{
+			endpoints.sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.sourcePoint = graph.aFaceCenter[ endpoints.sourceFace ];
+			endpoints.targetPoint = graph.aFaceCenter[ endpoints.targetFace ];
+		}
+		std::vector< float > aSerial( queryCount );
+		QueryContext query;
+		for( uint32_t i = 0; i < queryCount; i++ )
+		{
+			query.run( mesh , graph , aQueries[ i ] , QueryContext::ASTAR );
+			aSerial[ i ] = query.length;
+		}
+		uint32_t maxThreads = std::thread::hardware_concurrency();
+		maxThreads = maxThreads > 4 ? maxThreads : 4;
+		std::vector< PathResult > aResults;
+		uint32_t failures = 0;
+		for( uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2 )
+		{
+			BatchQuery batch( threadCount );
+			batch.run( mesh , graph , aQueries , aResults );
+			uint32_t mismatches = 0;
+			for( uint32_t i = 0; i < queryCount; i++ )
+			{
+				mismatches += aResults[ i ].distance != aSerial[ i ];
+			}
+			printf( "%-16s %8u faces  %u queries  %2u threads %10.1f queries/s  %5u steals  %u mismatches\n" ,
+				name , mesh.getFaceCount() , queryCount , threadCount , batch.stats.queriesPerSecond , batch.stats.steals , mismatches );
+			failures += mismatches;
+		}
+		return failures;
+	}
+	// Many targets from one source: one kept tree and corridor extraction against an A* search per target.
+	// Ties between dual paths may refine to different lengths, but the dual distances must agree.
+	static uint32_t singleSourceQueries( Mesh const &mesh , char const *name , uint32_t targetCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		srand( 4 );
+		SearchEndpoints endpoints;
+		endpoints.sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+		endpoints.sourcePoint = graph.aFaceCenter[ endpoints.sourceFace ];
+		SingleSourceQuery singleSource;
+		singleSource.setSource( graph , endpoints.sourceFace , endpoints.sourcePoint );
+		QueryContext query;
+		PathResult result;
+		double treeSeconds = 0.0 , astarSeconds = 0.0 , lengthRatio = 0.0;
+		uint32_t mismatches = 0;
+		for( uint32_t i = 0; i < targetCount; i++ )
+		{
+			endpoints.targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.targetPoint = graph.aFaceCenter[ endpoints.targetFace ];
+			singleSource.run( mesh , endpoints.targetFace , endpoints.targetPoint , result );
+			treeSeconds += singleSource.query.stats.seconds;
+			query.run( mesh , graph , endpoints , QueryContext::ASTAR );
+			astarSeconds += query.stats.seconds;
+			lengthRatio += query.length > 0.0f ? result.distance / query.length : 1.0;
+			float treeDist = singleSource.pTree->aDist[ endpoints.targetFace ] , searchDist = query.faceSearch.getDistance( endpoints.targetFace );
+			mismatches += fabsf( treeDist - searchDist ) > 1.0e-5f * searchDist;
+		}
+		printf( "%-16s %8u faces  %u targets  tree %9.3f ms + %8.3f ms per target  A* %8.3f ms per target  length ratio %.4f  %u mismatches\n" ,
+			name , mesh.getFaceCount() , targetCount , singleSource.pTree->seconds * 1000.0 , treeSeconds * 1000.0 / targetCount ,
+			astarSeconds * 1000.0 / targetCount , lengthRatio / targetCount , mismatches );
+		singleSource.release();
+		return mismatches;
+	}
+	// Skewed stream of repeated sources, a few hot faces and a long tail, with a budget of eight trees
+	static uint32_t sourceTreeCache( Mesh const &mesh , char const *name , uint32_t requestCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		srand( 5 );
+		uint32_t const sourceCount = 32;
+		std::vector< uint32_t > aSources( sourceCount );
+		std::vector< float3 > aSourcePoints( sourceCount );
+		for( uint32_t i = 0; i < sourceCount; i++ )
+		{
+			aSources[ i ] = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			aSourcePoints[ i ] = getRandomPoint( mesh , aSources[ i ] );
+		}
+		size_t treeBytes = sizeof( SourceTree ) + size_t( mesh.getFaceCount() ) * ( sizeof( float ) + sizeof( uint32_t ) );
+		SourceTreeCache cache( treeBytes * 8 );
+		SingleSourceQuery singleSource;
+		PathResult result;
+		double cachedSeconds = 0.0 , uncachedSeconds = 0.0;
+		uint32_t mismatches = 0;
+		for( uint32_t i = 0; i < requestCount; i++ )
+		{
+			// Squaring biases the pick towards the first sources
+			float u = float( rand() ) / RAND_MAX;
+			uint32_t source = std::min( uint32_t( u * u * sourceCount ) , sourceCount - 1 );
+			uint32_t sourceFace = aSources[ source ];
+			uint32_t targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			// Now and then a source moves within its face, which must not hit the old point's tree
+			if( rand() % 8 == 0 )
+			{
+				aSourcePoints[ source ] = getRandomPoint( mesh , sourceFace );
+			}
+			float3 sourcePoint = aSourcePoints[ source ];
+			float3 targetPoint = getRandomPoint( mesh , targetFace );
+			auto start = std::chrono::high_resolution_clock::now();
+			singleSource.setTree( cache.get( graph , sourceFace , sourcePoint , singleSource.faceSearch ) );
+			singleSource.run( mesh , targetFace , targetPoint , result );
+			cachedSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			float cachedDistance = result.distance;
+			start = std::chrono::high_resolution_clock::now();
+			singleSource.setSource( graph , sourceFace , sourcePoint );
+			singleSource.run( mesh , targetFace , targetPoint , result );
+			uncachedSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			if( fabsf( cachedDistance - result.distance ) > 1.0e-4f * fmaxf( result.distance , 1.0f ) )
+			{
+				mismatches++;
+			}
+		}
+		SourceTreeCacheStats stats = cache.getStats();
+		printf( "%-16s %8u faces  %u requests  hits %llu misses %llu evictions %llu  %u trees %.1f MB  cached %8.3f ms uncached %8.3f ms per request  mismatches %u\n" ,
+			name , mesh.getFaceCount() , requestCount , ( unsigned long long )stats.hits , ( unsigned long long )stats.misses ,
+			( unsigned long long )stats.evictions , stats.entries , stats.bytes / 1048576.0 ,
+			cachedSeconds * 1000.0 / requestCount , uncachedSeconds * 1000.0 / requestCount , mismatches );
+		singleSource.release();
+		return mismatches;
+	}
+	// A* against ALT with farthest point and random landmarks, tables go through a save and load first.
+	// ALT is exact, so distances may only differ by float rounding.
+	static uint32_t landmarkQueries( Mesh const &mesh , char const *name , uint32_t queryCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		uint32_t failures = 0;
+		Landmarks::Selection const aSelections[] = { Landmarks::FARTHEST , Landmarks::RANDOM };
+		for( Landmarks::Selection selection : aSelections )
+		{
+			Landmarks landmarks;
+			landmarks.build( graph , 16 , selection );
+			double buildSeconds = landmarks.stats.seconds;
+			bool loaded = landmarks.save( "bench.landmarks" ) && landmarks.load( "bench.landmarks" , graph );
+			remove( "bench.landmarks" );
+			srand( 6 );
+			QueryContext astar , alt;
+			alt.pLandmarks = &landmarks;
+			double astarSeconds = 0.0 , altSeconds = 0.0 , maxError = 0.0;
+			uint64_t astarSettled = 0 , altSettled = 0;
+			for( uint32_t i = 0; i < queryCount; i++ )
+			{
+				SearchEndpoints endpoints;
+				endpoints.sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+				endpoints.targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+				endpoints.sourcePoint = graph.aFaceCenter[ endpoints.sourceFace ];
+				endpoints.targetPoint = graph.aFaceCenter[ endpoints.targetFace ];
+				astar.run( mesh , graph , endpoints , QueryContext::ASTAR );
+				alt.run( mesh , graph , endpoints , QueryContext::ALT );
+				astarSeconds += astar.stats.seconds;
+				altSeconds += alt.stats.seconds;
+				astarSettled += astar.stats.search.settled;
+				altSettled += alt.stats.search.settled;
+				float astarDist = astar.faceSearch.getDistance( endpoints.targetFace );
+				float altDist = alt.faceSearch.getDistance( endpoints.targetFace );
+				if( astarDist > 0.0f )
+				{
+					maxError = std::max( maxError , double( fabsf( altDist - astarDist ) / astarDist ) );
+				}
+			}
+			printf( "%-16s %8u faces  %s %u landmarks %9.3f ms%s  A* %8.3f ms %9.1f settled  ALT %8.3f ms %9.1f settled  max error %.2e\n" ,
+				name , mesh.getFaceCount() , selection == Landmarks::FARTHEST ? "farthest" : "random  " , landmarks.getLandmarkCount() ,
+				buildSeconds * 1000.0 , loaded ? "" : " (reload failed)" , astarSeconds * 1000.0 / queryCount ,
+				double( astarSettled ) / queryCount , altSeconds * 1000.0 / queryCount , double( altSettled ) / queryCount , maxError );
+			failures += !loaded || maxError > 1.0e-5;
+		}
+		return failures;
+	}
+	// Random point on a face, uniform over its area
+	static float3 getRandomPoint( Mesh const &mesh , uint32_t face )
+	{
+		FaceRecord const &record = mesh.aFaceRecords[ face ];
+		float u = float( rand() ) / RAND_MAX , v = float( rand() ) / RAND_MAX;
+		if( u + v > 1.0f )
+		{
+			u = 1.0f - u;
+			v = 1.0f - v;
+		}
+		return record.p0 + record.e1 * u + record.e2 * v;
+	}
+	// Contraction hierarchy against A* between random points, both anchor the picked faces at them.
+	// Besides matching A*, the hierarchy has to settle fewer faces and answer faster.
+	static uint32_t hierarchyQueries( Mesh const &mesh , char const *name , uint32_t queryCount )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		ContractionHierarchy hierarchy;
+		hierarchy.build( graph );
+		srand( 7 );
+		FaceSearch faceSearch;
+		ContractionHierarchySearch hierarchySearch;
+		std::vector< uint32_t > corridor;
+		double astarSeconds = 0.0 , hierarchySeconds = 0.0 , maxError = 0.0;
+		uint64_t astarSettled = 0 , hierarchySettled = 0;
+		for( uint32_t i = 0; i < queryCount; i++ )
+		{
+			SearchEndpoints endpoints;
+			endpoints.sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.targetFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			endpoints.sourcePoint = getRandomPoint( mesh , endpoints.sourceFace );
+			endpoints.targetPoint = getRandomPoint( mesh , endpoints.targetFace );
+			auto start = std::chrono::high_resolution_clock::now();
+			faceSearch.run( graph , endpoints , false );
+			astarSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			start = std::chrono::high_resolution_clock::now();
+			hierarchySearch.run( graph , hierarchy , endpoints );
+			hierarchySearch.getCorridor( hierarchy , corridor );
+			hierarchySeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			astarSettled += faceSearch.stats.settled;
+			hierarchySettled += hierarchySearch.stats.settled;
+			float astarDist = faceSearch.getDistance( endpoints.targetFace );
+			if( astarDist > 0.0f )
+			{
+				maxError = std::max( maxError , double( fabsf( hierarchySearch.getDistance() - astarDist ) / astarDist ) );
+			}
+		}
+		uint32_t failures = ( maxError > 1.0e-5 ) + ( hierarchySettled > astarSettled ) + ( hierarchySeconds > astarSeconds );
+		printf( "%-16s %8u faces  hierarchy %9.3f ms %u shortcuts %u levels  A* %8.3f ms %9.1f settled  CH %8.3f ms %9.1f settled  max error %.2e  %u failures\n" ,
+			name , mesh.getFaceCount() , hierarchy.stats.seconds * 1000.0 , hierarchy.stats.shortcuts , hierarchy.stats.depth , astarSeconds * 1000.0 / queryCount ,
+			double( astarSettled ) / queryCount , hierarchySeconds * 1000.0 / queryCount , double( hierarchySettled ) / queryCount , maxError , failures );
+		return failures;
+	}
+	// Full distance field, serial flood against delta-stepping on 1 , 2 , 4 ... threads
+	static uint32_t deltaSteppingField( Mesh const &mesh , char const *name )
+	{
+		DualGraph graph;
+		graph.update( mesh );
+		srand( 8 );
+		uint32_t sourceFace = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+		float3 sourcePoint = graph.aFaceCenter[ sourceFace ];
+		SearchEndpoints endpoints;
+		endpoints.sourceFace = sourceFace;
+		endpoints.sourcePoint = sourcePoint;
+		FaceSearch faceSearch;
+		auto start = std::chrono::high_resolution_clock::now();
+		faceSearch.run( graph , endpoints , true );
+		double serialSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		printf( "%-16s %8u faces  serial flood %8.3f ms\n" , name , mesh.getFaceCount() , serialSeconds * 1000.0 );
+		uint32_t maxThreads = std::thread::hardware_concurrency();
+		maxThreads = maxThreads > 4 ? maxThreads : 4;
+		DeltaStepping deltaStepping;
+		double oneThreadSeconds = 0.0;
+		uint32_t failures = 0;
+		for( uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2 )
+		{
+			deltaStepping.threadCount = int( threadCount );
+			deltaStepping.run( graph , sourceFace , sourcePoint );
+			DeltaSteppingStats const &stats = deltaStepping.stats;
+			oneThreadSeconds = threadCount == 1 ? stats.seconds : oneThreadSeconds;
+			uint32_t mismatches = 0;
+			for( uint32_t face = 0; face < mesh.getFaceCount(); face++ )
+			{
+				mismatches += deltaStepping.getDistance( face ) != faceSearch.getDistance( face );
+			}
+			printf( "%-16s %8u faces  delta %.4f  %2u threads %8.3f ms  speedup %5.2f  %u buckets %u phases %u parallel  %u mismatches\n" ,
+				name , mesh.getFaceCount() , stats.delta , threadCount , stats.seconds * 1000.0 , oneThreadSeconds / stats.seconds ,
+				stats.buckets , stats.phases , stats.parallelPhases , mismatches );
+			failures += mismatches;
+		}
+		return failures;
+	}
+	// Rays from outside the mesh aimed at random face centroids, BVH against the collide() loop and the
+	// SIMD linear scan on the first few
+	static uint32_t picking( Mesh const &mesh , char const *name , uint32_t pickCount )
+	{
+		MeshBVH bvh;
+		bvh.build( mesh );
+		TriangleScan scan;
+		scan.build( mesh );
+		srand( 9 );
+		uint32_t checkCount = std::min( pickCount , 8u );
+		uint32_t hits = 0 , mismatches = 0;
+		double bvhSeconds = 0.0 , linearSeconds = 0.0 , scanSeconds = 0.0;
+		for( uint32_t i = 0; i < pickCount; i++ )
+		{
+			uint32_t face = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			float3 target = mesh.getFaceCenter( face );
+			float3 offset( float( rand() ) / RAND_MAX - 0.5f , float( rand() ) / RAND_MAX - 0.5f , float( rand() ) / RAND_MAX - 0.5f );
+			float3 pos = target + offset.norm() * 20.0f;
+			float3 dir = ( target - pos ).norm();
+			uint32_t hitFace;
+			float3 hitPoint;
+			auto start = std::chrono::high_resolution_clock::now();
+			hits += bvh.pick( pos , dir , hitFace , hitPoint );
+			bvhSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			if( i < checkCount )
+			{
+				start = std::chrono::high_resolution_clock::now();
+				float bestDist = FLT_MAX;
+				uint32_t linearFace = Mesh::INVALID;
+				for( uint32_t testFace = 0; testFace < mesh.getFaceCount(); testFace++ )
+				{
+					float3 proj;
+					if( mesh.collide( testFace , pos , dir , proj ) && proj.dist2( pos ) < bestDist )
+					{
+						bestDist = proj.dist2( pos );
+						linearFace = testFace;
+					}
+				}
+				linearSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+				uint32_t scanFace;
+				float3 scanPoint;
+				start = std::chrono::high_resolution_clock::now();
+				scan.pick( pos , dir , scanFace , scanPoint );
+				scanSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+				mismatches += linearFace != hitFace || scanFace != hitFace;
+			}
+		}
+		printf( "%-16s %8u faces  BVH %9.3f ms %u nodes depth %u  pick %8.3f us  collide loop %8.3f ms  SIMD scan %8.3f ms  %u/%u hits  %u mismatches\n" ,
+			name , mesh.getFaceCount() , bvh.stats.seconds * 1000.0 , bvh.stats.nodeCount , bvh.stats.maxDepth ,
+			bvhSeconds * 1.0e6 / pickCount , linearSeconds * 1000.0 / checkCount , scanSeconds * 1000.0 / checkCount ,
+			hits , pickCount , mismatches );
+		return mismatches;
+	}
+	// Points scattered off random surface points along the normal, as sensors report them. The batch
+	// runs through the BVH, the first few are checked against every face.
+	static uint32_t closestPoints( Mesh const &mesh , char const *name , uint32_t pointCount )
+	{
+		MeshBVH bvh;
+		bvh.build( mesh );
+		srand( 11 );
+		std::vector< float3 > aPoints( pointCount );
+		for( uint32_t i = 0; i < pointCount; i++ )
+		{
+			uint32_t face = uint32_t( rand() * ( RAND_MAX + 1u ) + rand() ) % mesh.getFaceCount();
+			FaceRecord const &record = mesh.aFaceRecords[ face ];
+			float v = float( rand() ) / RAND_MAX , w = float( rand() ) / RAND_MAX;
+			if( v + w > 1.0f )
+			{
+				v = 1.0f - v;
+				w = 1.0f - w;
+			}
+			aPoints[ i ] = record.p0 + record.e1 * v + record.e2 * w + record.normal * ( float( rand() ) / RAND_MAX - 0.5f ) * 0.2f;
+		}
+		std::vector< ClosestPoint > aResults;
+		auto start = std::chrono::high_resolution_clock::now();
+		bvh.closestPoints( aPoints , aResults );
+		double batchSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		uint32_t checkCount = std::min( pointCount , 16u );
+		uint32_t mismatches = 0;
+		double linearSeconds = 0.0;
+		for( uint32_t i = 0; i < checkCount; i++ )
+		{
+			start = std::chrono::high_resolution_clock::now();
+			float bestDist2 = FLT_MAX;
+			for( uint32_t face = 0; face < mesh.getFaceCount(); face++ )
+			{
+				float aWeights[ 3 ];
+				bestDist2 = std::min( bestDist2 , mesh.getClosestPoint( face , aPoints[ i ] , aWeights ).dist2( aPoints[ i ] ) );
+			}
+			linearSeconds += std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			// Ties on shared edges may pick either face, only the distance has to agree
+			mismatches += fabsf( sqrtf( bestDist2 ) - aResults[ i ].distance ) > 1.0e-5f;
+		}
+#ifdef _OPENMP
+		int threads = omp_get_max_threads();
+#else
+		int threads = 1;
+#endif
+		printf( "%-16s %8u faces  %8u points %2d threads %9.3f ms  %8.3f us per point  linear scan %8.3f ms  %u mismatches\n" ,
+			name , mesh.getFaceCount() , pointCount , threads , batchSeconds * 1000.0 , batchSeconds * 1.0e6 / pointCount ,
+			linearSeconds * 1000.0 / checkCount , mismatches );
+		return mismatches;
+	}
+	// A size x size grid of camera rays in 8x8 tiles, packets against one pick per ray
+	static uint32_t packetPicking( Mesh const &mesh , char const *name , uint32_t size )
+	{
+		MeshBVH bvh;
+		bvh.build( mesh );
+		float3 center = ( bvh.aNodes[ 0 ].boxMin + bvh.aNodes[ 0 ].boxMax ) * 0.5f;
+		float radius = bvh.aNodes[ 0 ].boxMin.dist( bvh.aNodes[ 0 ].boxMax ) * 0.5f;
+		Camera camera;
+		camera.lookAt( center + float3( 1.0f , 0.6f , 0.8f ).norm() * radius * 1.2f , center );
+		std::vector< float3 > aDirs;
+		aDirs.reserve( size * size );
+		for( uint32_t tileY = 0; tileY < size; tileY += 8 )
+		{
+			for( uint32_t tileX = 0; tileX < size; tileX += 8 )
+			{
+				for( uint32_t y = tileY; y < std::min( tileY + 8 , size ); y++ )
+				{
+					for( uint32_t x = tileX; x < std::min( tileX + 8 , size ); x++ )
+					{
+						aDirs.push_back( camera.getCameraRay( float2( ( x + 0.5f ) / size * 2.0f - 1.0f , ( y + 0.5f ) / size * 2.0f - 1.0f ) ) );
+					}
+				}
+			}
+		}
+		uint32_t rayCount = uint32_t( aDirs.size() );
+		std::vector< uint32_t > aHitFaces( rayCount );
+		std::vector< float3 > aHitPoints( rayCount );
+		auto start = std::chrono::high_resolution_clock::now();
+		bvh.pickRays( camera.pos , &aDirs[ 0 ] , rayCount , &aHitFaces[ 0 ] , &aHitPoints[ 0 ] );
+		double packetSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		uint32_t hits = 0 , mismatches = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for( uint32_t i = 0; i < rayCount; i++ )
+		{
+			uint32_t hitFace;
+			float3 hitPoint;
+			bvh.pick( camera.pos , aDirs[ i ] , hitFace , hitPoint );
+			hits += hitFace != Mesh::INVALID;
+			// A ray through an edge hits both faces at the same point, either may win depending on the order
+			mismatches += hitFace != aHitFaces[ i ] && ( hitFace == Mesh::INVALID || aHitFaces[ i ] == Mesh::INVALID || hitPoint.dist2( aHitPoints[ i ] ) > 0.0f );
+		}
+		double singleSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		printf( "%-16s %8u faces  %8u rays  packets %9.3f ms  single rays %9.3f ms  speedup %5.2f  %u hits  %u mismatches\n" ,
+			name , mesh.getFaceCount() , rayCount , packetSeconds * 1000.0 , singleSeconds * 1000.0 , singleSeconds / packetSeconds ,
+			hits , mismatches );
+		return mismatches;
+	}
+	// Every benchmark that fits an .obj of a few thousand faces
+	static uint32_t runObj( char const *path )
+	{
+		Mesh mesh;
+		if( !loadObj( mesh , path ) )
+		{
+			return 1;
+		}
+		uint32_t failures = 0;
+		failures += exactVsApprox( mesh , path , 64 );
+		failures += batchQueries( mesh , path , 1024 );
+		failures += singleSourceQueries( mesh , path , 256 );
+		failures += sourceTreeCache( mesh , path , 256 );
+		failures += landmarkQueries( mesh , path , 256 );
+		failures += hierarchyQueries( mesh , path , 256 );
+		failures += picking( mesh , path , 256 );
+		failures += closestPoints( mesh , path , 4096 );
+		failures += packetPicking( mesh , path , 512 );
+		failures += fieldsVsExact( mesh , path , 8 );
+		return failures;
+	}
+	// A torus of rings x rings / 2 quads, rings * rings faces. Past 512 rings only picking, closest
+	// points and the distance field scale in reasonable time.
+	static uint32_t runTorus( uint32_t rings )
+	{
+		Mesh mesh;
+		std::vector< float3 > positions;
+		std::vector< uint32_t > indices;
+		makeTorus( rings , rings / 2 , 4.0f , 1.5f , positions , indices );
+		MeshBuildStats buildStats;
+		if( !MeshBuilder::build( mesh , positions , indices , buildStats ) )
+		{
+			printf( "Failed to build a torus of %u rings\n" , rings );
+			return 1;
+		}
+		char name[ 32 ];
+		snprintf( name , sizeof( name ) , "torus %ux%u" , rings , rings / 2 );
+		uint32_t failures = 0;
+		if( rings <= 512 )
+		{
+			failures += exactVsApprox( mesh , name , 16 );
+			failures += batchQueries( mesh , name , 256 );
+			failures += singleSourceQueries( mesh , name , 256 );
+			failures += sourceTreeCache( mesh , name , 256 );
+			failures += landmarkQueries( mesh , name , 256 );
+			failures += hierarchyQueries( mesh , name , 256 );
+			if( rings <= 256 )
+			{
+				failures += fieldsVsExact( mesh , name , 4 );
+			}
+		} else
+		{
+			failures += picking( mesh , name , 1024 );
+			failures += closestPoints( mesh , name , 1 << 20 );
+			failures += packetPicking( mesh , name , 1024 );
+		}
+		failures += deltaSteppingField( mesh , name );
+		return failures;
+	}
+	// --bench [ mesh.obj | torus rings ]... , numbers are torus ring counts. Without arguments
+	// untitled.obj and tori of about 4K , 65K , 262K , 100K , 1M and 10M faces.
+	static int run( int argc , char **argv )
+	{
+		uint32_t failures = 0;
+		if( argc <= 2 )
+		{
+			failures += runObj( "untitled.obj" );
+			uint32_t const aTorusSizes[] = { 64 , 256 , 512 , 316 , 1024 , 3162 };
+			for( uint32_t rings : aTorusSizes )
+			{
+				failures += runTorus( rings );
+			}
+		}
+		for( int i = 2; i < argc; i++ )
+		{
+			char *end;
+			unsigned long rings = strtoul( argv[ i ] , &end , 10 );
+			if( *end == 0 && rings >= 4 )
+			{
+				failures += runTorus( uint32_t( rings ) );
+			} else
+			{
+				failures += runObj( argv[ i ] );
+			}
+		}
+		printf( "%u failures\n" , failures );
+		return failures ? 1 : 0;
+	}
+};
@@ -10,10 +10,16 @@
 #include "GLFW/glfw3.h"
 #include "math\vec.hpp"
 #include "Camera.hpp"
+#include "mesh/MeshBuilder.hpp"
+#include "mesh/MeshBVH.hpp"
+#include "geodesic/QueryContext.hpp"
+#include "geodesic/ExactGeodesic.hpp"
+#include "geodesic/HeatGeodesic.hpp"
+#include "geodesic/FastMarching.hpp"
+#include "Bench.hpp"
 #include <iostream>
 #include <memory>
 #include <unordered_set>
-#include <deque>
 using namespace Math;
 static void error_callback( int error , const char* description )
 {
@@ -32,92 +38,6 @@ static const char* fragment_shader_text =
 "{\n"
 "    gl_FragColor = vec4(color);//texture( tex , uv );\n"
 "}\n";
-struct Edge;
-struct HalfEdge;
-struct Face;
-
-struct Vertex
-{
-	float3 pos;
-	std::vector< Edge* > aEdges;
-	int useCounter;
-	Vertex( float3 pos ) :
-		pos( pos )
-	{}
-};
-struct Edge
-{
-	Vertex *pOrigin;
-	Vertex *pEnd;
-	std::vector< HalfEdge* > aHalfEdges;
-	int useCounter = 0;
-	Edge( Vertex *pOrigin , Vertex *pEnd ) :
-		pOrigin( pOrigin ) ,
-		pEnd( pEnd )
-	{
-		pEnd->useCounter++;
-		pOrigin->useCounter++;
-	}
-	~Edge()
-	{
-		if( !--pEnd->useCounter )
-		{
-			delete pEnd;
-		}
-		if( !--pOrigin->useCounter )
-		{
-			delete pEnd;
-		}
-	}
-	float3 getNormal() const
-	{
-		return ( pEnd->pos - pOrigin->pos ).norm();
-	}
-	float getLength() const
-	{
-		return ( pEnd->pos - pOrigin->pos ).mod();
-	}
-};
-struct HalfEdge
-{
-	Edge *pEdge;
-	HalfEdge *pNext , *pPrev;
-	bool orient;
-	Face *pFace;
-	Face *getAdjacentFace() const
-	{
-		return pEdge->aHalfEdges[ 0 ] == this ? pEdge->aHalfEdges[ 1 ]->pFace : pEdge->aHalfEdges[ 0 ]->pFace;
-	}
-	HalfEdge( Edge *pEdge , Face *pFace , bool orient ) :
-		pEdge( pEdge ) ,
-		pFace( pFace ) ,
-		orient( orient )
-	{
-		pEdge->aHalfEdges.push_back( this );
-		pEdge->useCounter++;
-	}
-	float3 getOrigin() const
-	{
-		if( orient )
-		{
-			return pEdge->pOrigin->pos;
-		} else
-		{
-			return pEdge->pEnd->pos;
-		}
-	}
-	float3 getCenter() const
-	{
-		return ( pEdge->pEnd->pos + pEdge->pOrigin->pos ) / 2;
-	}
-	~HalfEdge()
-	{
-		if( !--pEdge->useCounter )
-		{
-			delete pEdge;
-		}
-	}
-};
 struct DrawList
 {
 	std::vector< float > aPositions;
@@ -139,101 +59,33 @@ struct DrawList
 		aIndices.push_back( topIndex + 2 );
 	}
 };
-struct Face
+enum SearchMode
 {
-	std::vector< HalfEdge* > loop;
-	float dist = 0.0f;
-	Face *pFromFace;
-	float3 getCenter() const
-	{
-		return ( loop[ 0 ]->getOrigin() + loop[ 1 ]->getOrigin() + loop[ 2 ]->getOrigin() ) / 3.0f;
-	}
-	Edge *getFromEdge()
-	{
-		for( auto hedge : loop )
-		{
-			if( hedge->getAdjacentFace() == pFromFace )
-			{
-				return hedge->pEdge;
-			}
-		}
-		return nullptr;
-	}
-	void draw( DrawList &drawList) const
-	{
-		drawList.pushTriangle( loop[ 0 ]->getOrigin() , loop[ 1 ]->getOrigin() , loop[ 2 ]->getOrigin() );
-	}
-	bool collide( float3 const &pos , float3 const &v , float3 &proj )
-	{
-		auto p0 = loop[ 0 ]->getOrigin();
-		auto p1 = loop[ 1 ]->getOrigin();
-		auto p2 = loop[ 2 ]->getOrigin();
-		if( p0.dist2( p1 ) < MathUtil< float >::EPS
-			|| p1.dist2( p2 ) < MathUtil< float >::EPS 
-			|| p2.dist2( p0 ) < MathUtil< float >::EPS )
-		{
-			return false;
-		}
-		auto norm = ( ( p1 - p0 ) ^ ( p2 - p0 ) ).norm();
-		auto dr = pos - p0;
-		auto perpDist = dr * norm;
-		auto linearDist = -perpDist / ( v * norm );
-		if( linearDist < 0.0f )
-		{
-			return false;
-		}
-		proj = pos + v * linearDist;
-		auto area = ( ( p1 - p0 ) ^ ( p2 - p0 ) ).mod();
-		return fabsf( (
-			( ( proj - p0 ) ^ ( proj - p1 ) ).mod() +
-			( ( proj - p1 ) ^ ( proj - p2 ) ).mod() +
-			( ( proj - p2 ) ^ ( proj - p0 ) ).mod()
-			) / area - 1.0f ) < 1.0e-3f;
-	}
-	~Face()
-	{
-		for( auto &hedge : loop )
-		{
-			delete hedge;
-		}
-	}
+	SEARCH_ASTAR ,
+	SEARCH_ALT ,
+	SEARCH_FLOOD ,
+	SEARCH_BIDIRECTIONAL ,
+	SEARCH_HIERARCHY ,
+	SEARCH_EXACT ,
+	SEARCH_HEAT ,
+	SEARCH_FAST_MARCHING ,
+	SEARCH_MODE_COUNT
 };
-typedef std::shared_ptr< Face > FacePTR;
-void createHalfEdge( Face *pFace , Vertex *pOrigin , Vertex *pEnd )
+static const char* searchModeNames[ SEARCH_MODE_COUNT ] = { "A*" , "ALT" , "flood" , "bidirectional" , "hierarchy" , "exact" , "heat" , "fast marching" };
+Mesh mesh;
+DualGraph dualGraph;
+MeshBVH meshBVH;
+Landmarks landmarks;
+ContractionHierarchy hierarchy;
+int main( int argc , char **argv )
 {
-	Edge *pEdge = nullptr;
-	bool order = true;
-	for( auto const &pIterEdge : pOrigin->aEdges )
-	{
-		if( pIterEdge->pOrigin == pOrigin && pIterEdge->pEnd == pEnd )
-		{
-			pEdge = pIterEdge;
-			break;
-		}
-		if( pIterEdge->pEnd == pOrigin && pIterEdge->pOrigin == pEnd )
-		{
-			order = false;
-			pEdge = pIterEdge;
-			break;
-		}
-	}
-	if( !pEdge )
+	if( argc > 1 && strcmp( argv[ 1 ] , "--bench" ) == 0 )
 	{
-		pEdge = new Edge( pOrigin , pEnd );
-		pOrigin->aEdges.push_back( pEdge );
-		pEnd->aEdges.push_back( pEdge );
+		return Bench::run( argc , argv );
 	}
-
-	auto pHalfEdge = new HalfEdge( pEdge , pFace , order );
-	pFace->loop.push_back( pHalfEdge );
-	pHalfEdge->pNext = pFace->loop[ 0 ];
-	pHalfEdge->pPrev = pFace->loop[ pFace->loop.size() - 1 ];
-	pFace->loop[ 0 ]->pPrev = pHalfEdge;
-}
-std::vector< Vertex* > vertices;
-std::vector< Face* > faces;
-int main()
-{
+	// Mesh to open, derived files such as the landmark table are named after it
+	char const *meshPath = argc > 1 ? argv[ 1 ] : "test.obj";
+	std::string landmarksPath = std::string( meshPath ) + ".landmarks";
 	GLFWwindow* window;
 	GLuint vertex_buffer , line_buffer , index_buffer , vertex_shader , fragment_shader , program;
 	glfwSetErrorCallback( error_callback );
@@ -260,7 +112,7 @@ int main()
 		std::vector<tinyobj::material_t> materials;
 
 		std::string err;
-		bool ret = tinyobj::LoadObj( &attrib , &shapes , &materials , &err , "test.obj" , "" , true );
+		bool ret = tinyobj::LoadObj( &attrib , &shapes , &materials , &err , meshPath , "" , true );
 
 		if( !err.empty() )
 		{
@@ -272,29 +124,38 @@ int main()
 			printf( "Failed to load/parse .obj.\n" );
 			return false;
 		}
-		for( int i = 0; i < attrib.vertices.size() / 3; i++ )
+		MeshBuildStats buildStats;
+		if( !MeshBuilder::build( mesh , attrib , shapes[ 0 ].mesh.indices , buildStats ) )
 		{
-			vertices.push_back(
-				new Vertex{
-					{attrib.vertices[ i * 3 ] ,attrib.vertices[ i * 3 + 1 ] ,attrib.vertices[ i * 3 + 2 ] }
-			} );
-		}
-		for( int i = 0; i < shapes[ 0 ].mesh.indices.size() / 3; i++ )
-		{
-			auto vertex0 = vertices[ shapes[ 0 ].mesh.indices[ i * 3 ].vertex_index ];
-			auto vertex1 = vertices[ shapes[ 0 ].mesh.indices[ i * 3 + 1 ].vertex_index ];
-			auto vertex2 = vertices[ shapes[ 0 ].mesh.indices[ i * 3 + 2 ].vertex_index ];
-			auto pFace = new Face();
-			createHalfEdge( pFace , vertex0 , vertex1 );
-			createHalfEdge( pFace , vertex1 , vertex2 );
-			createHalfEdge( pFace , vertex2 , vertex0 );
-			faces.push_back( pFace );
+			printf( "Rejected .obj: %u non-manifold edges, %u non-manifold vertices, %u degenerate faces.\n" ,
+				buildStats.nonManifoldEdgeCount , buildStats.nonManifoldVertexCount , buildStats.degenerateFaceCount );
+			return false;
 		}
+		printf( "Mesh built in %.3f ms: %u faces, %u edges, %u boundary edges\n" ,
+			buildStats.seconds * 1000.0 , mesh.getFaceCount() , buildStats.edgeCount , buildStats.boundaryEdgeCount );
+		MeshMemoryStats memoryStats = mesh.getMemoryStats();
+		printf( "Mesh memory: %zu vertex bytes, %zu half-edge bytes, %zu face bytes, %zu reserved\n" ,
+			memoryStats.vertexBytes , memoryStats.halfEdgeBytes , memoryStats.faceBytes , memoryStats.reservedBytes );
+	}
+	dualGraph.update( mesh );
+	meshBVH.update( mesh );
+	printf( "BVH built in %.3f ms: %u nodes, depth %u\n" , meshBVH.stats.seconds * 1000.0 , meshBVH.stats.nodeCount , meshBVH.stats.maxDepth );
+	// Landmark tables live next to the mesh as <mesh path>.landmarks, the first run on a mesh pays for the floods
+	if( landmarks.load( landmarksPath.c_str() , dualGraph ) )
+	{
+		printf( "Landmarks loaded in %.3f ms: %u landmarks\n" , landmarks.stats.seconds * 1000.0 , landmarks.stats.landmarks );
+	} else
+	{
+		landmarks.build( dualGraph , 16 , Landmarks::FARTHEST );
+		printf( "Landmarks built in %.3f ms: %u landmarks%s\n" , landmarks.stats.seconds * 1000.0 , landmarks.stats.landmarks ,
+			landmarks.save( landmarksPath.c_str() ) ? "" : ", failed to save" );
 	}
 	DrawList drawList;
-	for( auto pFace : faces )
+	for( uint32_t face = 0; face < mesh.getFaceCount(); face++ )
 	{
-		pFace->draw( drawList );
+		float3 p0 , p1 , p2;
+		mesh.getFaceVertices( face , p0 , p1 , p2 );
+		drawList.pushTriangle( p0 , p1 , p2 );
 	}
 	glGenBuffers( 1 , &index_buffer );
 	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , index_buffer );
@@ -330,18 +191,18 @@ int main()
 	int mouseDown = 0;
 	glPointSize( 10.0f );
 	float3 points[ 2 ] = { {0.0f , 0.0f , 0.0f } , { 0.0f , 0.0f , 0.0f } };
-	Face *aFaces[ 2 ] = { nullptr };
+	uint32_t aFaces[ 2 ] = { Mesh::INVALID , Mesh::INVALID };
+	QueryContext query;
+	query.pLandmarks = &landmarks;
+	query.pHierarchy = &hierarchy;
+	ExactGeodesic exactGeodesic;
+	HeatGeodesic heatGeodesic;
+	FastMarching fastMarching;
+	std::vector< float3 > surfacePath;
+	int searchMode = SEARCH_ASTAR;
+	int modeKeyDown = 0;
+	int hierarchyKeyDown = 0;
 	int pointIndex = 0;
-	struct Collision
-	{
-		float3 norm , pos;
-		float t , length , dt;
-		float3 getPos() const
-		{
-			return pos + norm * t;
-		}
-	};
-	std::vector< Collision > collisions;
 	while( !glfwWindowShouldClose( window ) )
 	{
 		int width , height;
@@ -367,63 +228,70 @@ int main()
 				float u = xpos / width * 2.0f - 1.0f;
 				float v = ypos / height * 2.0f - 1.0f;
 				float3 ray = ( cameraLook * 1.0f / MathUtil< float >::tan( 0.7f ) + cameraLeft * u + cameraUp * v ).norm();
-				float minDist = 1000.0f;
-				Face *pCollidedFace = nullptr;
-				for( auto pFace : faces )
-				{
-					float3 lproj;
-					if( pFace->collide( cameraPos , ray , lproj ) && lproj.dist2( cameraPos ) < minDist )
-					{
-						minDist = lproj.dist2( cameraPos );
-						pCollidedFace = pFace;
-						proj = lproj;
-					}
-				}
-				if( pCollidedFace )
+				uint32_t collidedFace;
+				if( meshBVH.pick( cameraPos , ray , collidedFace , proj ) )
 				{
 					points[ pointIndex ] = proj;
-					aFaces[ pointIndex ] = pCollidedFace;
-					if( aFaces[ 0 ] && aFaces[ 1 ] )
+					aFaces[ pointIndex ] = collidedFace;
+					if( aFaces[ 0 ] != Mesh::INVALID && aFaces[ 1 ] != Mesh::INVALID )
 					{
-						collisions.clear();
-						for( auto pFace : faces )
+						surfacePath.clear();
+						if( searchMode == SEARCH_EXACT )
 						{
-							pFace->dist = 9999.0f;
-							pFace->pFromFace = nullptr;
-						}
-						std::deque< Face* > faceQ;
-						faceQ.push_back( aFaces[ 0 ] );
-						aFaces[ 0 ]->dist = 0.0f;
-						[ & ]()
+							exactGeodesic.run( mesh , aFaces[ 0 ] , points[ 0 ] , aFaces[ 1 ] , points[ 1 ] );
+							exactGeodesic.getPath( aFaces[ 1 ] , points[ 1 ] , surfacePath );
+							ExactGeodesicStats const &stats = exactGeodesic.stats;
+							printf( "Exact geodesic: %f in %.3f ms, %u windows, %u pruned, %u vertex sources\n" ,
+								exactGeodesic.getDistance( aFaces[ 1 ] , points[ 1 ] ) , stats.seconds * 1000.0 ,
+								stats.windowsCreated , stats.windowsPruned , stats.vertexSources );
+						} else if( searchMode == SEARCH_FAST_MARCHING )
 						{
-							while( !faceQ.empty() )
+							fastMarching.run( mesh , aFaces[ 0 ] , points[ 0 ] , aFaces[ 1 ] );
+							fastMarching.getPath( aFaces[ 1 ] , points[ 1 ] , surfacePath );
+							float length = 0.0f;
+							for( size_t i = 0; i + 1 < surfacePath.size(); i++ )
 							{
-								Face *seed = faceQ.front();
-								faceQ.pop_front();
-								float3 center = seed == aFaces[ 0 ] ? points[ 0 ] : seed == aFaces[ 1 ] ? points[ 1 ] : seed->getCenter();
-								for( auto &hedge : seed->loop )
+								length += surfacePath[ i ].dist( surfacePath[ i + 1 ] );
+							}
+							printf( "Fast marching: path %f in %.3f ms, %u accepted, %u split updates\n" , length ,
+								fastMarching.stats.seconds * 1000.0 , fastMarching.stats.accepted , fastMarching.stats.splitUpdates );
+						} else if( searchMode == SEARCH_HEAT )
+						{
+							// The first query after a load pays for the factorizations
+							if( heatGeodesic.run( mesh , aFaces[ 0 ] , points[ 0 ] ) )
+							{
+								heatGeodesic.getPath( aFaces[ 1 ] , points[ 1 ] , surfacePath );
+								float length = 0.0f;
+								for( size_t i = 0; i + 1 < surfacePath.size(); i++ )
 								{
-									Face *adjFace = hedge->getAdjacentFace();
-									float dist = seed->dist + hedge->getCenter().dist( center) + adjFace->getCenter().dist( hedge->getCenter() );
-									if( dist < adjFace->dist )
-									{
-										adjFace->dist = dist;
-										adjFace->pFromFace = seed;
-										/*if( adjFace == aFaces[ 1 ] )
-										{
-											return;
-										}*/
-										faceQ.push_back( adjFace );
-									}
+									length += surfacePath[ i ].dist( surfacePath[ i + 1 ] );
 								}
+								printf( "Heat geodesic: %f, path %f, factored in %.3f ms, solved in %.3f ms\n" ,
+									heatGeodesic.getDistance( aFaces[ 1 ] , points[ 1 ] ) , length ,
+									heatGeodesic.stats.buildSeconds * 1000.0 , heatGeodesic.stats.solveSeconds * 1000.0 );
+							} else
+							{
+								printf( "Heat geodesic: factorization failed\n" );
 							}
-						}( );
-						Face *pFace = aFaces[ 1 ];
-						while( pFace != nullptr && pFace != aFaces[ 0 ] )
+						} else
 						{
-							auto edge = pFace->getFromEdge();
-							collisions.push_back( { edge->getNormal() , edge->pOrigin->pos , edge->getLength() * 0.5f , edge->getLength() } );
-							pFace = pFace->pFromFace;
+							SearchEndpoints endpoints;
+							endpoints.sourceFace = aFaces[ 0 ];
+							endpoints.sourcePoint = points[ 0 ];
+							endpoints.targetFace = aFaces[ 1 ];
+							endpoints.targetPoint = points[ 1 ];
+							QueryContext::Method method = searchMode == SEARCH_BIDIRECTIONAL ? QueryContext::BIDIRECTIONAL :
+								searchMode == SEARCH_FLOOD ? QueryContext::FLOOD :
+								searchMode == SEARCH_ALT ? QueryContext::ALT :
+								searchMode == SEARCH_HIERARCHY ? QueryContext::HIERARCHY : QueryContext::ASTAR;
+							query.run( mesh , dualGraph , endpoints , method );
+							query.getPath( surfacePath );
+							QueryStats const &stats = query.stats;
+							printf( "Face search (%s): %u settled, %u pushed, %u decreased, funnel %f through %u portals\n" ,
+								searchModeNames[ searchMode ] , stats.search.settled , stats.search.pushed , stats.search.decreased ,
+								query.corridorFunnel.length , stats.funnel.portals );
+							printf( "Collision refine: %u iterations, residual %.3e, path %f in %.3f ms\n" ,
+								stats.refine.iterations , stats.refine.residual , query.length , stats.seconds * 1000.0 );
 						}
 					}
 				}
@@ -435,6 +303,31 @@ int main()
 		{
 			mouseDown = 0;
 		}
+		int modeKeyState = glfwGetKey( window , GLFW_KEY_M );
+		if( modeKeyState == GLFW_PRESS && !modeKeyDown )
+		{
+			// The hierarchy blocks the window while it is built, it is only entered through H
+			do
+			{
+				searchMode = ( searchMode + 1 ) % SEARCH_MODE_COUNT;
+			} while( searchMode == SEARCH_HIERARCHY );
+			printf( "Face search mode: %s\n" , searchModeNames[ searchMode ] );
+		}
+		modeKeyDown = modeKeyState == GLFW_PRESS;
+		int hierarchyKeyState = glfwGetKey( window , GLFW_KEY_H );
+		if( hierarchyKeyState == GLFW_PRESS && !hierarchyKeyDown )
+		{
+			if( !hierarchy.isValid( dualGraph ) )
+			{
+				printf( "Building the hierarchy, this takes a while on large meshes\n" );
+				hierarchy.build( dualGraph );
+				printf( "Hierarchy built in %.3f ms: %u shortcuts, %u up arcs, %u dissection levels\n" , hierarchy.stats.seconds * 1000.0 ,
+					hierarchy.stats.shortcuts , hierarchy.stats.upArcs , hierarchy.stats.depth );
+			}
+			searchMode = SEARCH_HIERARCHY;
+			printf( "Face search mode: %s\n" , searchModeNames[ searchMode ] );
+		}
+		hierarchyKeyDown = hierarchyKeyState == GLFW_PRESS;
 		if( mouseDown )
 		{
 			auto dx = -(xpos - xlastPos)/width;
@@ -469,79 +362,23 @@ int main()
 		
 		glDisable( GL_DEPTH_TEST );
 		glUniform4f( 0 , 1.0f , 0.0f , 0.0f , 1.0f );
-		auto der = []( Collision const &ci , Collision const &cj )
+		if( aFaces[ 0 ] != Mesh::INVALID && aFaces[ 1 ] != Mesh::INVALID )
 		{
-			return cj.t * ( cj.norm * ci.norm ) + ci.norm * cj.pos;
-		};
-		if( aFaces[ 0 ] && aFaces[ 1 ] )
-		{
-			for( int iter = 0; iter < 10; iter++ )
+			std::vector< float > lines;
+			for( auto const &point : surfacePath )
 			{
-				if( collisions.size() > 1 )
-				{
-#pragma omp parallel for
-					for( int i = 0; i < collisions.size(); i++ )
-					{
-						float3 point0 , point1;
-						if( i == 0 )
-						{
-							point0 = points[ 1 ];
-							point1 = collisions[ i + 1 ].getPos();
-						} else if( i == collisions.size() - 1 )
-						{
-							point0 = collisions[ i - 1 ].getPos();
-							point1 = points[ 0 ];
-						} else
-						{
-							point0 = collisions[ i - 1 ].getPos();
-							point1 = collisions[ i + 1 ].getPos();
-						}
-						
-
-						float B = collisions[ i ].t + collisions[ i ].norm * collisions[ i ].pos;
-						float dist0 = collisions[ i ].getPos().dist( point0 ) + 0.001f;
-						float dt0 = collisions[ i ].norm * point0 - B;
-						float dist1 = collisions[ i ].getPos().dist( point1 ) + 0.001f;
-						float dt1 = collisions[ i ].norm * point1 - B;
-						collisions[ i ].dt = dt0 / dist0 + dt1 / dist1;
-					}
-				} else if( collisions.size() )
-				{
-					float dist0 = collisions[ 0 ].getPos().dist( points[ 0 ] );
-					float dt0 = collisions[ 0 ].norm * points[ 0 ] - (
-						collisions[ 0 ].t + collisions[ 0 ].norm * collisions[ 0 ].pos
-						);
-					float dist1 = collisions[ 0 ].getPos().dist( points[ 1 ] );
-					float dt1 = collisions[ 0 ].norm * points[ 1 ] -(
-						collisions[ 0 ].t + collisions[ 0 ].norm * collisions[ 0 ].pos
-						);
-					collisions[ 0 ].dt = dt0 / dist0 + dt1 / dist1;
-				}
-				for( auto &col : collisions )
-				{
-					col.t += col.dt * 0.01f;
-					col.t = fmaxf( 0.0f , fminf( col.t , col.length ) );
-				}
+				lines.push_back( point.x );
+				lines.push_back( point.y );
+				lines.push_back( point.z );
 			}
-			std::vector< float > lines;
-			lines.push_back( points[ 1 ].x );
-			lines.push_back( points[ 1 ].y );
-			lines.push_back( points[ 1 ].z );
-			for( auto &col : collisions )
+			if( !lines.empty() )
 			{
-				float3 center = col.getPos();
-				lines.push_back( center.x );
-				lines.push_back( center.y );
-				lines.push_back( center.z );
+				glBindBuffer( GL_ARRAY_BUFFER , line_buffer );
+				glBufferData( GL_ARRAY_BUFFER , lines.size() * 4 , &lines[ 0 ] , GL_STATIC_DRAW );
+				glEnableVertexAttribArray( 0 );
+				glVertexAttribPointer( 0 , 3 , GL_FLOAT , GL_FALSE , 12 , 0 );
+				glDrawArrays( GL_LINE_STRIP , 0 , lines.size() / 3 );
 			}
-			lines.push_back( points[ 0 ].x );
-			lines.push_back( points[ 0 ].y );
-			lines.push_back( points[ 0 ].z );
-			glBindBuffer( GL_ARRAY_BUFFER , line_buffer );
-			glBufferData( GL_ARRAY_BUFFER , lines.size() * 4 , &lines[ 0 ] , GL_STATIC_DRAW );
-			glEnableVertexAttribArray( 0 );
-			glVertexAttribPointer( 0 , 3 , GL_FLOAT , GL_FALSE , 12 , 0 );
-			glDrawArrays( GL_LINE_STRIP , 0 , lines.size() / 3 );
 		}
 		glBegin( GL_POINTS );
 		glVertex3f( points[ 0 ].x , points[ 0 ].y , points[ 0 ].z );
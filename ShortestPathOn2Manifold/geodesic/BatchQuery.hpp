@@ -0,0 +1,71 @@
+#pragma once
+#include "geodesic/QueryContext.hpp"
+#include "geodesic/WorkStealingPool.hpp"
+#include <chrono>
+struct BatchQueryStats
+{
+	uint32_t queries = 0;
+	uint32_t unreached = 0;
+	uint32_t threads = 0;
+	uint32_t steals = 0;
+	double seconds = 0.0;
+	double queriesPerSecond = 0.0;
+};
+// Answers a list of point-to-point queries on the work stealing pool, one QueryContext per worker.
+// Results land at the index of their query, so the output order never depends on the schedule.
+struct BatchQuery
+{
+	WorkStealingPool pool;
+	std::vector< QueryContext > aContexts;
+	// Queries per stolen or popped range, small enough to balance long and short queries
+	uint32_t grain = 4;
+	BatchQueryStats stats;
+	explicit BatchQuery( uint32_t threadCount = std::thread::hardware_concurrency() ) :
+		pool( threadCount ) ,
+		aContexts( pool.getThreadCount() )
+	{
+	}
+	// Shared read-only by every worker, used by QueryContext::ALT
+	void setLandmarks( Landmarks const *pLandmarks )
+	{
+		for( auto &query : aContexts )
+		{
+			query.pLandmarks = pLandmarks;
+		}
+	}
+	// Shared read-only by every worker, used by QueryContext::HIERARCHY
+	void setHierarchy( ContractionHierarchy const *pHierarchy )
+	{
+		for( auto &query : aContexts )
+		{
+			query.pHierarchy = pHierarchy;
+		}
+	}
+	// graph must be up to date for mesh, both are only read
+	void run( Mesh const &mesh , DualGraph const &graph , std::vector< SearchEndpoints > const &aQueries ,
+		std::vector< PathResult > &aResults , QueryContext::Method method = QueryContext::ASTAR )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		aResults.resize( aQueries.size() );
+		uint32_t steals = pool.steals;
+		std::atomic< uint32_t > unreached( 0 );
+		pool.run( uint32_t( aQueries.size() ) , grain , [ & ]( uint32_t worker , uint32_t begin , uint32_t end )
+		{
+			QueryContext &query = aContexts[ worker ];
+			for( uint32_t i = begin; i < end; i++ )
+			{
+				if( !query.run( mesh , graph , aQueries[ i ] , method ) )
+				{
+					unreached++;
+				}
+				query.getResult( aResults[ i ] );
+			}
+		} );
+		stats.queries = uint32_t( aQueries.size() );
+		stats.unreached = unreached;
+		stats.threads = pool.getThreadCount();
+		stats.steals = pool.steals - steals;
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		stats.queriesPerSecond = stats.seconds > 0.0 ? stats.queries / stats.seconds : 0.0;
+	}
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include "geodesic/FaceSearch.hpp"
+#include <algorithm>
+// Dijkstra grown from both picked faces at once. Arc weights are symmetric, so the backward
+// search walks the same arcs. mu is the best source-target path seen through any face reached
+// by both sides, and the search stops once the two heap tops add up to at least mu.
+struct BidirectionalSearch
+{
+	enum
+	{
+		FORWARD = 0 ,
+		BACKWARD = 1
+	};
+	IndexedHeap< 4 > aHeaps[ 2 ];
+	FaceLabels aLabels[ 2 ];
+	FaceSearchStats stats;
+	SearchEndpoints endpoints;
+	float mu = FLT_MAX;
+	uint32_t meetFace = Mesh::INVALID;
+	void reset( uint32_t faceCount )
+	{
+		ito( 2 )
+		{
+			if( aLabels[ i ].aLabels.size() != faceCount )
+			{
+				aHeaps[ i ].init( faceCount );
+			} else
+			{
+				aHeaps[ i ].clear();
+			}
+			aLabels[ i ].begin( faceCount );
+		}
+		stats = FaceSearchStats();
+		mu = FLT_MAX;
+		meetFace = Mesh::INVALID;
+	}
+	void run( DualGraph const &graph , SearchEndpoints const &endpoints )
+	{
+		this->endpoints = endpoints;
+		reset( graph.getFaceCount() );
+		uint32_t aRoots[ 2 ] = { endpoints.sourceFace , endpoints.targetFace };
+		ito( 2 )
+		{
+			aLabels[ i ].set( aRoots[ i ] , 0.0f , Mesh::INVALID );
+			aHeaps[ i ].push( aRoots[ i ] , 0.0f );
+			stats.pushed++;
+		}
+		if( endpoints.sourceFace == endpoints.targetFace )
+		{
+			mu = 0.0f;
+			meetFace = endpoints.sourceFace;
+			return;
+		}
+		while( !aHeaps[ FORWARD ].empty() && !aHeaps[ BACKWARD ].empty()
+			&& aHeaps[ FORWARD ].getTopKey() + aHeaps[ BACKWARD ].getTopKey() < mu )
+		{
+			int side = aHeaps[ FORWARD ].size() <= aHeaps[ BACKWARD ].size() ? FORWARD : BACKWARD;
+			int other = side ^ 1;
+			FaceLabels &sideLabels = aLabels[ side ];
+			FaceLabels const &otherLabels = aLabels[ other ];
+			uint32_t face = aHeaps[ side ].pop();
+			stats.settled++;
+			float faceDist = sideLabels.getDist( face );
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjFace = graph.aArcFace[ arc ];
+				float dist = faceDist + endpoints.getArcWeight( graph , face , arc );
+				float sideDist = sideLabels.getDist( adjFace );
+				if( dist < sideDist )
+				{
+					sideDist = dist;
+					sideLabels.set( adjFace , dist , face );
+					if( aHeaps[ side ].pushOrDecrease( adjFace , dist ) )
+					{
+						stats.pushed++;
+					} else
+					{
+						stats.decreased++;
+					}
+				}
+				float otherDist = otherLabels.getDist( adjFace );
+				if( otherDist != FLT_MAX && sideDist + otherDist < mu )
+				{
+					mu = sideDist + otherDist;
+					meetFace = adjFace;
+				}
+			}
+		}
+	}
+	float getDistance() const
+	{
+		return mu;
+	}
+	// Faces from the target back to the source, same order as FaceSearch::getCorridor
+	void getCorridor( std::vector< uint32_t > &aCorridor ) const
+	{
+		aCorridor.clear();
+		if( meetFace == Mesh::INVALID )
+		{
+			return;
+		}
+		uint32_t face = meetFace;
+		while( face != endpoints.targetFace )
+		{
+			face = aLabels[ BACKWARD ].getFrom( face );
+			aCorridor.push_back( face );
+		}
+		std::reverse( aCorridor.begin() , aCorridor.end() );
+		face = meetFace;
+		aCorridor.push_back( face );
+		while( face != endpoints.sourceFace )
+		{
+			face = aLabels[ FORWARD ].getFrom( face );
+			aCorridor.push_back( face );
+		}
+	}
+};
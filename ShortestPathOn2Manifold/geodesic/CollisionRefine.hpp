@@ -0,0 +1,227 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <math.h>
+#include <chrono>
+#include <vector>
+// Point where a path crosses a mesh edge, t is the distance from the edge origin pos along the unit direction norm
+struct Collision
+{
+	float3 norm , pos;
+	float t , length;
+	float3 getPos() const
+	{
+		return pos + norm * t;
+	}
+};
+struct CollisionRefineStats
+{
+	uint32_t iterations = 0;
+	// Newton decrement at exit, the length the next step would still remove relative to the length
+	double residual = 0.0;
+	double seconds = 0.0;
+};
+// Minimizes the length of the polyline start -> collisions -> end over all t in [ 0 , length ].
+// Each t only touches its two segments, so the Hessian is tridiagonal and a projected Newton step
+// (Bertsekas) costs one linear pass: variables held at a bound by the gradient are fixed, the others
+// take a damped Newton step and the result is projected back onto the box with an Armijo backtrack.
+struct CollisionRefine
+{
+	struct Point3
+	{
+		double x , y , z;
+	};
+	uint32_t maxIterations = 100;
+	double tolerance = 1e-8;
+	// Segment lengths are smoothed to sqrt( l^2 + eps^2 ) with eps = smoothing * longest edge, so crossings
+	// meeting at a vertex keep a defined gradient
+	double smoothing = 1e-5;
+	// A start whose first decrement exceeds warmStart is far from optimal and restarts at the coarser
+	// continuation smoothing, which is shrunk tenfold each time it converges
+	double warmStart = 1e-5;
+	double continuation = 1e-2;
+	// Relative distance to a bound under which a variable pushed against it counts as active
+	double activeBand = 1e-4;
+	double epsilon = 0.0;
+	// Segment k runs from point k to point k + 1, point 0 is start and point n + 1 is end
+	std::vector< Point3 > aPoints;
+	std::vector< double > aSegmentLength;
+	std::vector< Point3 > aSegmentDir;
+	std::vector< double > aGradient;
+	std::vector< double > aDiag;
+	std::vector< double > aUpper;
+	std::vector< double > aStep;
+	// Eliminated upper diagonal of the forward sweep
+	std::vector< double > aSweep;
+	std::vector< uint8_t > aFixed;
+	// Parameters are iterated in double and written back to the collisions on exit
+	std::vector< double > aT;
+	std::vector< double > aBase;
+	CollisionRefineStats stats;
+	static double dot( Point3 const &a , float3 const &b )
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+	static double getLength( float3 const &start , float3 const &end , std::vector< Collision > const &collisions )
+	{
+		double length = 0.0;
+		float3 prev = start;
+		for( auto const &col : collisions )
+		{
+			length += prev.dist( col.getPos() );
+			prev = col.getPos();
+		}
+		return length + prev.dist( end );
+	}
+	// Smoothed length with its gradient and tridiagonal Hessian, points are formed in double precision
+	double evaluate( float3 const &start , float3 const &end , std::vector< Collision > const &collisions )
+	{
+		size_t n = collisions.size();
+		aPoints[ 0 ] = { start.x , start.y , start.z };
+		for( size_t i = 0; i < n; i++ )
+		{
+			Collision const &col = collisions[ i ];
+			double t = aT[ i ];
+			aPoints[ i + 1 ] = { col.pos.x + col.norm.x * t , col.pos.y + col.norm.y * t , col.pos.z + col.norm.z * t };
+		}
+		aPoints[ n + 1 ] = { end.x , end.y , end.z };
+		double length = 0.0;
+		for( size_t k = 0; k <= n; k++ )
+		{
+			Point3 v = { aPoints[ k + 1 ].x - aPoints[ k ].x , aPoints[ k + 1 ].y - aPoints[ k ].y , aPoints[ k + 1 ].z - aPoints[ k ].z };
+			double segment = sqrt( v.x * v.x + v.y * v.y + v.z * v.z + epsilon * epsilon );
+			length += segment;
+			aSegmentLength[ k ] = segment;
+			aSegmentDir[ k ] = { v.x / segment , v.y / segment , v.z / segment };
+		}
+		// d/dt of the segment along direction d is d.w with w = v / l, the curvature is ( 1 - ( d.w )^2 ) / l
+		for( size_t i = 0; i < n; i++ )
+		{
+			float3 const &d = collisions[ i ].norm;
+			double before = dot( aSegmentDir[ i ] , d );
+			double after = dot( aSegmentDir[ i + 1 ] , d );
+			aGradient[ i ] = before - after;
+			aDiag[ i ] = ( 1.0 - before * before ) / aSegmentLength[ i ] + ( 1.0 - after * after ) / aSegmentLength[ i + 1 ];
+			if( i + 1 < n )
+			{
+				float3 const &e = collisions[ i + 1 ].norm;
+				aUpper[ i ] = -( double( d * e ) - after * dot( aSegmentDir[ i + 1 ] , e ) ) / aSegmentLength[ i + 1 ];
+			}
+		}
+		return length;
+	}
+	CollisionRefineStats const &run( float3 const &start , float3 const &end , std::vector< Collision > &collisions )
+	{
+		auto begin = std::chrono::high_resolution_clock::now();
+		stats = CollisionRefineStats();
+		size_t n = collisions.size();
+		float longest = 0.0f;
+		aT.resize( n );
+		for( size_t i = 0; i < n; i++ )
+		{
+			longest = collisions[ i ].length > longest ? collisions[ i ].length : longest;
+			aT[ i ] = collisions[ i ].t;
+		}
+		epsilon = smoothing * longest;
+		aPoints.resize( n + 2 );
+		aSegmentLength.resize( n + 1 );
+		aSegmentDir.resize( n + 1 );
+		aGradient.resize( n );
+		aDiag.resize( n );
+		aUpper.resize( n );
+		aStep.resize( n );
+		aSweep.resize( n );
+		aFixed.resize( n );
+		aBase.resize( n );
+		double length = evaluate( start , end , collisions );
+		for( ; ; stats.iterations++ )
+		{
+			// A variable within the band of a bound it is pushed against is active and snaps onto the bound
+			for( size_t i = 0; i < n; i++ )
+			{
+				double room = aGradient[ i ] > 0.0 ? aT[ i ] : collisions[ i ].length - aT[ i ];
+				aFixed[ i ] = room <= collisions[ i ].length * activeBand;
+			}
+			// Thomas algorithm on the free rows, active rows are decoupled with the step onto their bound.
+			// The Hessian is only semi-definite where the path runs along an edge, a small shift keeps the pivots positive.
+			double shift = 0.0;
+			for( size_t i = 0; i < n; i++ )
+			{
+				shift = aDiag[ i ] > shift ? aDiag[ i ] : shift;
+			}
+			shift = shift * 1e-10 + 1e-12;
+			double prevUpper = 0.0 , prevStep = 0.0;
+			for( size_t i = 0; i < n; i++ )
+			{
+				double lower = i > 0 && !aFixed[ i ] && !aFixed[ i - 1 ] ? aUpper[ i - 1 ] : 0.0;
+				double upper = i + 1 < n && !aFixed[ i ] && !aFixed[ i + 1 ] ? aUpper[ i ] : 0.0;
+				double diag = aFixed[ i ] ? 1.0 : aDiag[ i ] + shift;
+				double rhs = !aFixed[ i ] ? -aGradient[ i ] : aGradient[ i ] > 0.0 ? -aT[ i ] : collisions[ i ].length - aT[ i ];
+				double pivot = diag - lower * prevUpper;
+				prevUpper = upper / pivot;
+				prevStep = ( rhs - lower * prevStep ) / pivot;
+				aSweep[ i ] = prevUpper;
+				aStep[ i ] = prevStep;
+			}
+			double decrement = 0.0;
+			if( n > 0 )
+			{
+				for( size_t i = n - 1; i-- > 0; )
+				{
+					aStep[ i ] -= aSweep[ i ] * aStep[ i + 1 ];
+				}
+				for( size_t i = 0; i < n; i++ )
+				{
+					decrement -= aGradient[ i ] * aStep[ i ];
+				}
+			}
+			// Newton decrement: the length the step expects to remove, relative to the current length
+			stats.residual = length > 0.0 ? decrement / length : 0.0;
+			if( stats.iterations == 0 && stats.residual > warmStart )
+			{
+				epsilon = continuation * longest;
+				length = evaluate( start , end , collisions );
+				continue;
+			}
+			if( stats.residual <= tolerance && epsilon > smoothing * longest )
+			{
+				epsilon = fmax( epsilon * 0.1 , smoothing * longest );
+				length = evaluate( start , end , collisions );
+				continue;
+			}
+			if( stats.residual <= tolerance || stats.iterations >= maxIterations )
+			{
+				break;
+			}
+			// Backtrack along the projected arc until the length drops enough
+			aBase.assign( aT.begin() , aT.end() );
+			double alpha = 1.0 , trialLength = length;
+			for( uint32_t halving = 0; halving < 40; halving++ , alpha *= 0.5 )
+			{
+				double decrease = 0.0;
+				for( size_t i = 0; i < n; i++ )
+				{
+					double t = aBase[ i ] + alpha * aStep[ i ];
+					aT[ i ] = t < 0.0 ? 0.0 : t > collisions[ i ].length ? collisions[ i ].length : t;
+					decrease += aGradient[ i ] * ( aBase[ i ] - aT[ i ] );
+				}
+				trialLength = evaluate( start , end , collisions );
+				if( trialLength <= length - 1e-4 * decrease )
+				{
+					break;
+				}
+			}
+			if( trialLength > length )
+			{
+				aT.swap( aBase );
+				break;
+			}
+			length = trialLength;
+		}
+		for( size_t i = 0; i < n; i++ )
+		{
+			collisions[ i ].t = float( aT[ i ] );
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - begin ).count();
+		return stats;
+	}
+};
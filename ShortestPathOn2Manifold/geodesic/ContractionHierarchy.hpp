@@ -0,0 +1,498 @@
+#pragma once
+#include "geodesic/FaceSearch.hpp"
+#include <algorithm>
+#include <chrono>
+struct ContractionHierarchyStats
+{
+	uint32_t shortcuts = 0;
+	uint32_t upArcs = 0;
+	// Arcs of the elimination graph, before the ones that are no shortest path are left out
+	uint32_t filledArcs = 0;
+	uint64_t triangles = 0;
+	// Levels of the nested dissection
+	uint32_t depth = 0;
+	double seconds = 0.0;
+};
+// Contraction hierarchy over the centroid weights of the dual graph. Each face keeps arcs to higher
+// ranked faces only, and a shortcut remembers the face it bypasses so it can be unpacked into the face
+// chain it stands for.
+// A mesh has no hierarchy of its own for edge difference to find, so the order comes from nested
+// dissection: the centroids of a cell are split at the median of their longest axis, the faces of the
+// smaller side bordering the other side form the separator and are ranked above both halves. Every
+// face gets contracted, and a query only climbs through the separators of the cells around its ends.
+// With the order known up front there are no witness searches. Contracting every face without one
+// gives the elimination graph, where the higher neighbours of each face form a clique. Its weights are
+// set bottom-up through the triangles below each arc, then top-down through the triangles beside and
+// above it, after which every weight is a true distance. Arcs whose weight dropped in the second pass
+// are no shortest path and are left out, which keeps the shortcuts an unbounded witness search keeps.
+struct ContractionHierarchy
+{
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	std::vector< uint32_t > aRank;
+	// Upward arcs of face f are [ aUpOffsets[ f ] , aUpOffsets[ f + 1 ] ), all to higher ranked faces
+	std::vector< uint32_t > aUpOffsets;
+	std::vector< uint32_t > aUpArcFace;
+	std::vector< float > aUpArcWeight;
+	// Bypassed face of a shortcut, Mesh::INVALID for an arc of the dual graph
+	std::vector< uint32_t > aUpArcMiddle;
+	// Cells of at most this many faces are not split any further
+	uint32_t leafFaces = 16;
+	ContractionHierarchyStats stats;
+	bool isValid( DualGraph const &graph ) const
+	{
+		return pMesh == graph.pMesh && meshVersion == graph.meshVersion && !aRank.empty();
+	}
+	void build( DualGraph const &graph )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		pMesh = graph.pMesh;
+		meshVersion = graph.meshVersion;
+		stats = ContractionHierarchyStats();
+		uint32_t faceCount = graph.getFaceCount();
+		std::vector< uint32_t > aOrder;
+		getDissectionOrder( graph , aOrder );
+		aRank.resize( faceCount );
+		for( uint32_t rank = 0; rank < faceCount; rank++ )
+		{
+			aRank[ aOrder[ rank ] ] = rank;
+		}
+		// Elimination graph over ranks, the higher neighbours of each rank in ascending order. The lowest
+		// of them is the parent, and the parent's list holds all the others, so a list is the rank's own
+		// arcs merged with the lists of its children.
+		std::vector< uint32_t > aOffsets( faceCount + 1 , 0 );
+		std::vector< uint32_t > aArcRank;
+		std::vector< uint32_t > aFirstChild( faceCount , Mesh::INVALID );
+		std::vector< uint32_t > aNextSibling( faceCount , Mesh::INVALID );
+		std::vector< uint32_t > aMark( faceCount , Mesh::INVALID );
+		aArcRank.reserve( size_t( faceCount ) * 8 );
+		for( uint32_t rank = 0; rank < faceCount; rank++ )
+		{
+			uint32_t begin = uint32_t( aArcRank.size() );
+			uint32_t face = aOrder[ rank ];
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjRank = aRank[ graph.aArcFace[ arc ] ];
+				if( adjRank > rank && aMark[ adjRank ] != rank )
+				{
+					aMark[ adjRank ] = rank;
+					aArcRank.push_back( adjRank );
+				}
+			}
+			for( uint32_t child = aFirstChild[ rank ]; child != Mesh::INVALID; child = aNextSibling[ child ] )
+			{
+				// The first arc of a child leads to rank itself
+				for( uint32_t arc = aOffsets[ child ] + 1; arc < aOffsets[ child + 1 ]; arc++ )
+				{
+					uint32_t adjRank = aArcRank[ arc ];
+					if( aMark[ adjRank ] != rank )
+					{
+						aMark[ adjRank ] = rank;
+						aArcRank.push_back( adjRank );
+					}
+				}
+			}
+			std::sort( aArcRank.begin() + begin , aArcRank.end() );
+			aOffsets[ rank + 1 ] = uint32_t( aArcRank.size() );
+			if( aOffsets[ rank + 1 ] > begin )
+			{
+				uint32_t parent = aArcRank[ begin ];
+				aNextSibling[ rank ] = aFirstChild[ parent ];
+				aFirstChild[ parent ] = rank;
+			}
+		}
+		uint32_t arcCount = aOffsets[ faceCount ];
+		stats.filledArcs = arcCount;
+		auto findArc = [ & ]( uint32_t rank , uint32_t adjRank )
+		{
+			return uint32_t( std::lower_bound( aArcRank.begin() + aOffsets[ rank ] , aArcRank.begin() + aOffsets[ rank + 1 ] , adjRank ) - aArcRank.begin() );
+		};
+		// Shortest path through lower ranks only and the highest rank on it, bottom-up so the two lower
+		// arcs of a triangle are final before the arc above them
+		std::vector< float > aLower( arcCount , FLT_MAX );
+		std::vector< uint32_t > aMiddle( arcCount , Mesh::INVALID );
+		for( uint32_t rank = 0; rank < faceCount; rank++ )
+		{
+			uint32_t face = aOrder[ rank ];
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjRank = aRank[ graph.aArcFace[ arc ] ];
+				if( adjRank > rank )
+				{
+					uint32_t upArc = findArc( rank , adjRank );
+					aLower[ upArc ] = std::min( aLower[ upArc ] , graph.aArcWeight[ arc ] );
+				}
+			}
+		}
+		for( uint32_t rank = 0; rank < faceCount; rank++ )
+		{
+			forTriangles( aOffsets , aArcRank , rank , [ & ]( uint32_t a , uint32_t b , uint32_t c )
+			{
+				float weight = aLower[ a ] + aLower[ b ];
+				if( weight < aLower[ c ] )
+				{
+					aLower[ c ] = weight;
+					aMiddle[ c ] = rank;
+				}
+			} );
+			uint64_t upCount = aOffsets[ rank + 1 ] - aOffsets[ rank ];
+			stats.triangles += upCount > 1 ? upCount * ( upCount - 1 ) / 2 : 0;
+		}
+		// Top-down the arcs above a triangle already hold distances, so the detours through higher
+		// ranks are complete when the arcs below are reached
+		std::vector< float > aDist( aLower );
+		for( uint32_t rank = faceCount; rank-- > 0; )
+		{
+			forTriangles( aOffsets , aArcRank , rank , [ & ]( uint32_t a , uint32_t b , uint32_t c )
+			{
+				aDist[ a ] = std::min( aDist[ a ] , aDist[ b ] + aDist[ c ] );
+				aDist[ b ] = std::min( aDist[ b ] , aDist[ a ] + aDist[ c ] );
+			} );
+		}
+		// Kept arcs pull in the two arcs they unpack into, whatever rounding did to those
+		std::vector< uint8_t > aKeep( arcCount );
+		for( uint32_t arc = 0; arc < arcCount; arc++ )
+		{
+			aKeep[ arc ] = aDist[ arc ] >= aLower[ arc ];
+		}
+		for( uint32_t rank = faceCount; rank-- > 0; )
+		{
+			for( uint32_t arc = aOffsets[ rank ]; arc < aOffsets[ rank + 1 ]; arc++ )
+			{
+				uint32_t middle = aMiddle[ arc ];
+				if( aKeep[ arc ] && middle != Mesh::INVALID )
+				{
+					aKeep[ findArc( middle , rank ) ] = 1;
+					aKeep[ findArc( middle , aArcRank[ arc ] ) ] = 1;
+				}
+			}
+		}
+		aUpOffsets.resize( faceCount + 1 );
+		aUpOffsets[ 0 ] = 0;
+		for( uint32_t face = 0; face < faceCount; face++ )
+		{
+			uint32_t rank = aRank[ face ];
+			uint32_t upCount = 0;
+			for( uint32_t arc = aOffsets[ rank ]; arc < aOffsets[ rank + 1 ]; arc++ )
+			{
+				upCount += aKeep[ arc ];
+			}
+			aUpOffsets[ face + 1 ] = aUpOffsets[ face ] + upCount;
+		}
+		stats.upArcs = aUpOffsets[ faceCount ];
+		aUpArcFace.resize( stats.upArcs );
+		aUpArcWeight.resize( stats.upArcs );
+		aUpArcMiddle.resize( stats.upArcs );
+		for( uint32_t face = 0; face < faceCount; face++ )
+		{
+			uint32_t rank = aRank[ face ];
+			uint32_t upArc = aUpOffsets[ face ];
+			for( uint32_t arc = aOffsets[ rank ]; arc < aOffsets[ rank + 1 ]; arc++ )
+			{
+				if( !aKeep[ arc ] )
+				{
+					continue;
+				}
+				aUpArcFace[ upArc ] = aOrder[ aArcRank[ arc ] ];
+				aUpArcWeight[ upArc ] = aLower[ arc ];
+				aUpArcMiddle[ upArc ] = aMiddle[ arc ] == Mesh::INVALID ? Mesh::INVALID : aOrder[ aMiddle[ arc ] ];
+				stats.shortcuts += aMiddle[ arc ] != Mesh::INVALID;
+				upArc++;
+			}
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Calls visit( a , b , c ) for the triangles of the elimination graph with rank at the bottom: arcs a
+	// and b of rank to the two other corners, c between those two and stored with the lower one
+	template< typename Visit >
+	static void forTriangles( std::vector< uint32_t > const &aOffsets , std::vector< uint32_t > const &aArcRank , uint32_t rank , Visit const &visit )
+	{
+		for( uint32_t a = aOffsets[ rank ]; a < aOffsets[ rank + 1 ]; a++ )
+		{
+			// Both lists ascend and the higher neighbours of rank past a are all neighbours of a's end
+			uint32_t c = aOffsets[ aArcRank[ a ] ];
+			for( uint32_t b = a + 1; b < aOffsets[ rank + 1 ]; b++ )
+			{
+				while( aArcRank[ c ] != aArcRank[ b ] )
+				{
+					c++;
+				}
+				visit( a , b , c );
+			}
+		}
+	}
+	// Contraction order, lowest rank first: both halves of a cell, then its separator
+	void getDissectionOrder( DualGraph const &graph , std::vector< uint32_t > &aOrder )
+	{
+		uint32_t faceCount = graph.getFaceCount();
+		std::vector< uint32_t > aFaces( faceCount );
+		for( uint32_t face = 0; face < faceCount; face++ )
+		{
+			aFaces[ face ] = face;
+		}
+		// Cell of each face while its parent is split, ids are never reused
+		std::vector< uint32_t > aCell( faceCount , 0 );
+		uint32_t cellCount = 1;
+		aOrder.clear();
+		aOrder.reserve( faceCount );
+		dissect( graph , aFaces , 0 , faceCount , 0 , aCell , cellCount , aOrder );
+	}
+	void dissect( DualGraph const &graph , std::vector< uint32_t > &aFaces , uint32_t begin , uint32_t end , uint32_t depth ,
+		std::vector< uint32_t > &aCell , uint32_t &cellCount , std::vector< uint32_t > &aOrder )
+	{
+		stats.depth = std::max( stats.depth , depth + 1 );
+		if( end - begin <= leafFaces )
+		{
+			aOrder.insert( aOrder.end() , aFaces.begin() + begin , aFaces.begin() + end );
+			return;
+		}
+		float3 boxMin( FLT_MAX ) , boxMax( -FLT_MAX );
+		for( uint32_t i = begin; i < end; i++ )
+		{
+			float3 const &center = graph.aFaceCenter[ aFaces[ i ] ];
+			for( int axis = 0; axis < 3; axis++ )
+			{
+				boxMin[ axis ] = std::min( boxMin[ axis ] , center[ axis ] );
+				boxMax[ axis ] = std::max( boxMax[ axis ] , center[ axis ] );
+			}
+		}
+		float3 extent = boxMax - boxMin;
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+		uint32_t mid = begin + ( end - begin ) / 2;
+		std::nth_element( aFaces.begin() + begin , aFaces.begin() + mid , aFaces.begin() + end ,
+			[ & ]( uint32_t a , uint32_t b ) { return graph.aFaceCenter[ a ][ axis ] < graph.aFaceCenter[ b ][ axis ]; } );
+		uint32_t aCellIds[ 2 ] = { cellCount , cellCount + 1 };
+		cellCount += 2;
+		for( uint32_t i = begin; i < end; i++ )
+		{
+			aCell[ aFaces[ i ] ] = aCellIds[ i < mid ? 0 : 1 ];
+		}
+		// Faces of a side with a neighbour on the other side, the smaller count becomes the separator
+		auto isBorder = [ & ]( uint32_t face )
+		{
+			uint32_t otherCell = aCellIds[ aCell[ face ] == aCellIds[ 0 ] ? 1 : 0 ];
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				if( aCell[ graph.aArcFace[ arc ] ] == otherCell )
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+		uint32_t aBorder[ 2 ] = { 0 , 0 };
+		for( uint32_t i = begin; i < end; i++ )
+		{
+			aBorder[ i < mid ? 0 : 1 ] += isBorder( aFaces[ i ] );
+		}
+		uint32_t separatorCell = aCellIds[ aBorder[ 0 ] <= aBorder[ 1 ] ? 0 : 1 ];
+		// Separator faces move to the back of the range, each half keeps its faces in front of it
+		auto keep = std::stable_partition( aFaces.begin() + begin , aFaces.begin() + end ,
+			[ & ]( uint32_t face ) { return aCell[ face ] != separatorCell || !isBorder( face ); } );
+		uint32_t separatorBegin = uint32_t( keep - aFaces.begin() );
+		uint32_t split = uint32_t( std::stable_partition( aFaces.begin() + begin , aFaces.begin() + separatorBegin ,
+			[ & ]( uint32_t face ) { return aCell[ face ] == aCellIds[ 0 ]; } ) - aFaces.begin() );
+		dissect( graph , aFaces , begin , split , depth + 1 , aCell , cellCount , aOrder );
+		dissect( graph , aFaces , split , separatorBegin , depth + 1 , aCell , cellCount , aOrder );
+		aOrder.insert( aOrder.end() , aFaces.begin() + separatorBegin , aFaces.begin() + end );
+	}
+	// Up arc between two faces joined in the hierarchy, stored with the lower ranked one
+	uint32_t findUpArc( uint32_t faceA , uint32_t faceB ) const
+	{
+		uint32_t lower = aRank[ faceA ] < aRank[ faceB ] ? faceA : faceB;
+		uint32_t higher = lower == faceA ? faceB : faceA;
+		for( uint32_t arc = aUpOffsets[ lower ]; arc < aUpOffsets[ lower + 1 ]; arc++ )
+		{
+			if( aUpArcFace[ arc ] == higher )
+			{
+				return arc;
+			}
+		}
+		return Mesh::INVALID;
+	}
+	// Appends the dual graph faces after from up to and including to, in path order
+	void unpack( uint32_t from , uint32_t to , std::vector< uint32_t > &aFaces ) const
+	{
+		std::vector< std::pair< uint32_t , uint32_t > > stack;
+		stack.push_back( { from , to } );
+		while( !stack.empty() )
+		{
+			auto edge = stack.back();
+			stack.pop_back();
+			uint32_t middle = aUpArcMiddle[ findUpArc( edge.first , edge.second ) ];
+			if( middle == Mesh::INVALID )
+			{
+				aFaces.push_back( edge.second );
+			} else
+			{
+				stack.push_back( { middle , edge.second } );
+				stack.push_back( { edge.first , middle } );
+			}
+		}
+	}
+};
+// Bidirectional Dijkstra over the upward arcs only, both sides climb the hierarchy and meet at the
+// highest ranked face of the shortest path. Each side stops once its heap top reaches mu.
+// The hierarchy only knows centroid weights, so like FaceSearch the first and last arcs are anchored
+// at the picked points: each side starts from the neighbours of its picked face, at the anchored
+// weight of the arc to them. Arc weights run through edge midpoints, so by the triangle inequality a
+// path returning through a picked face is never shorter than leaving it directly, and the distance
+// matches FaceSearch.
+struct ContractionHierarchySearch
+{
+	enum
+	{
+		FORWARD = 0 ,
+		BACKWARD = 1
+	};
+	IndexedHeap< 4 > aHeaps[ 2 ];
+	FaceLabels aLabels[ 2 ];
+	FaceSearchStats stats;
+	SearchEndpoints endpoints;
+	float mu = FLT_MAX;
+	uint32_t meetFace = Mesh::INVALID;
+	// Picked faces are the same or adjacent and no hierarchy path was shorter
+	bool direct = false;
+	void reset( uint32_t faceCount )
+	{
+		ito( 2 )
+		{
+			if( aLabels[ i ].aLabels.size() != faceCount )
+			{
+				aHeaps[ i ].init( faceCount );
+			} else
+			{
+				aHeaps[ i ].clear();
+			}
+			aLabels[ i ].begin( faceCount );
+		}
+		stats = FaceSearchStats();
+		mu = FLT_MAX;
+		meetFace = Mesh::INVALID;
+		direct = false;
+	}
+	// hierarchy must be valid for graph
+	void run( DualGraph const &graph , ContractionHierarchy const &hierarchy , SearchEndpoints const &endpoints )
+	{
+		this->endpoints = endpoints;
+		reset( graph.getFaceCount() );
+		uint32_t aRoots[ 2 ] = { endpoints.sourceFace , endpoints.targetFace };
+		if( aRoots[ FORWARD ] == aRoots[ BACKWARD ] )
+		{
+			mu = 0.0f;
+			direct = true;
+			return;
+		}
+		ito( 2 )
+		{
+			for( uint32_t arc = graph.aOffsets[ aRoots[ i ] ]; arc < graph.aOffsets[ aRoots[ i ] + 1 ]; arc++ )
+			{
+				uint32_t adjFace = graph.aArcFace[ arc ];
+				float dist = endpoints.getArcWeight( graph , aRoots[ i ] , arc );
+				if( adjFace == aRoots[ i ^ 1 ] )
+				{
+					if( dist < mu )
+					{
+						mu = dist;
+						direct = true;
+					}
+					continue;
+				}
+				if( dist < aLabels[ i ].getDist( adjFace ) )
+				{
+					aLabels[ i ].set( adjFace , dist , Mesh::INVALID );
+					aHeaps[ i ].pushOrDecrease( adjFace , dist );
+					stats.pushed++;
+				}
+			}
+		}
+		int side = FORWARD;
+		while( true )
+		{
+			bool aActive[ 2 ];
+			ito( 2 )
+			{
+				aActive[ i ] = !aHeaps[ i ].empty() && aHeaps[ i ].getTopKey() < mu;
+			}
+			if( !aActive[ FORWARD ] && !aActive[ BACKWARD ] )
+			{
+				break;
+			}
+			if( !aActive[ side ] )
+			{
+				side ^= 1;
+			}
+			FaceLabels &sideLabels = aLabels[ side ];
+			FaceLabels const &otherLabels = aLabels[ side ^ 1 ];
+			uint32_t face = aHeaps[ side ].pop();
+			stats.settled++;
+			float faceDist = sideLabels.getDist( face );
+			float otherDist = otherLabels.getDist( face );
+			if( otherDist != FLT_MAX && faceDist + otherDist < mu )
+			{
+				mu = faceDist + otherDist;
+				meetFace = face;
+				direct = false;
+			}
+			for( uint32_t arc = hierarchy.aUpOffsets[ face ]; arc < hierarchy.aUpOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjFace = hierarchy.aUpArcFace[ arc ];
+				float dist = faceDist + hierarchy.aUpArcWeight[ arc ];
+				if( dist < sideLabels.getDist( adjFace ) )
+				{
+					sideLabels.set( adjFace , dist , face );
+					if( aHeaps[ side ].pushOrDecrease( adjFace , dist ) )
+					{
+						stats.pushed++;
+					} else
+					{
+						stats.decreased++;
+					}
+				}
+			}
+			side ^= 1;
+		}
+	}
+	float getDistance() const
+	{
+		return mu;
+	}
+	// Faces from the target back to the source with every shortcut unpacked, same order as
+	// FaceSearch::getCorridor
+	void getCorridor( ContractionHierarchy const &hierarchy , std::vector< uint32_t > &aCorridor ) const
+	{
+		aCorridor.clear();
+		if( direct )
+		{
+			aCorridor.push_back( endpoints.targetFace );
+			if( endpoints.sourceFace != endpoints.targetFace )
+			{
+				aCorridor.push_back( endpoints.sourceFace );
+			}
+			return;
+		}
+		if( meetFace == Mesh::INVALID )
+		{
+			return;
+		}
+		aCorridor.push_back( endpoints.targetFace );
+		// Hierarchy path from a neighbour of the target up to the meeting face and down to a
+		// neighbour of the source
+		std::vector< uint32_t > aHierarchyPath;
+		for( uint32_t face = meetFace; face != Mesh::INVALID; face = aLabels[ BACKWARD ].getFrom( face ) )
+		{
+			aHierarchyPath.push_back( face );
+		}
+		std::reverse( aHierarchyPath.begin() , aHierarchyPath.end() );
+		for( uint32_t face = aLabels[ FORWARD ].getFrom( meetFace ); face != Mesh::INVALID; face = aLabels[ FORWARD ].getFrom( face ) )
+		{
+			aHierarchyPath.push_back( face );
+		}
+		aCorridor.push_back( aHierarchyPath[ 0 ] );
+		for( size_t i = 0; i + 1 < aHierarchyPath.size(); i++ )
+		{
+			hierarchy.unpack( aHierarchyPath[ i ] , aHierarchyPath[ i + 1 ] , aCorridor );
+		}
+		aCorridor.push_back( endpoints.sourceFace );
+	}
+};
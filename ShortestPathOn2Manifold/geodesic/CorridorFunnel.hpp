@@ -0,0 +1,248 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <math.h>
+#include <chrono>
+struct CorridorFunnelStats
+{
+	uint32_t portals = 0;
+	uint32_t apexes = 0;
+	double seconds = 0.0;
+};
+// Shortest path restricted to a strip of faces. The corridor is unfolded into the plane face by face,
+// the shared edges become portals and the simple stupid funnel (Mononen) pulls the string taut
+// through them. The result is exact for the given face sequence.
+struct CorridorFunnel
+{
+	struct Point2
+	{
+		double x , y;
+	};
+	// Portal 0 is the start point, portal n the end point, the ones between are the shared edges.
+	// Left is the end of the portal half-edge and right its origin, as seen walking along the corridor.
+	std::vector< Point2 > aLeft;
+	std::vector< Point2 > aRight;
+	std::vector< uint32_t > aPortalHalfEdge;
+	// Taut path in the unfolded plane and the portal each of its points sits on
+	std::vector< Point2 > aPath;
+	std::vector< uint32_t > aPathPortal;
+	// Distance from the portal half-edge origin to where the path crosses it, one per shared edge
+	std::vector< float > aCrossings;
+	double length = 0.0;
+	CorridorFunnelStats stats;
+	// Twice the signed area of abc, positive if c lies left of a -> b
+	static double cross( Point2 const &a , Point2 const &b , Point2 const &c )
+	{
+		return ( b.x - a.x ) * ( c.y - a.y ) - ( b.y - a.y ) * ( c.x - a.x );
+	}
+	static bool equal( Point2 const &a , Point2 const &b )
+	{
+		return a.x == b.x && a.y == b.y;
+	}
+	// Unfolded position of the vertex opposite hedge, left of its origin -> end given in the plane
+	static Point2 unfoldThird( Mesh const &mesh , uint32_t hedge , Point2 const &origin , Point2 const &end )
+	{
+		float3 const &o = mesh.getOrigin( hedge );
+		float3 axis = mesh.aPositions[ mesh.getEnd( hedge ) ] - o;
+		float3 rel = mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ) - o;
+		double axisLength = axis.mod();
+		double along = double( rel * axis ) / axisLength;
+		double across = double( ( rel ^ axis ).mod() ) / axisLength;
+		double ex = ( end.x - origin.x ) / axisLength , ey = ( end.y - origin.y ) / axisLength;
+		return { origin.x + ex * along - ey * across , origin.y + ey * along + ex * across };
+	}
+	// Point of face mapped through the face's unfolded corners, given in getFaceVertices order
+	static Point2 mapPoint( Mesh const &mesh , uint32_t face , float3 const &point , Point2 const aCorners[ 3 ] )
+	{
+		float aWeights[ 3 ];
+		mesh.getBarycentric( face , point , aWeights );
+		Point2 mapped = { 0.0 , 0.0 };
+		ito( 3 )
+		{
+			mapped.x += aWeights[ i ] * aCorners[ i ].x;
+			mapped.y += aWeights[ i ] * aCorners[ i ].y;
+		}
+		return mapped;
+	}
+	// Unfolded corners of hedge's face in getFaceVertices order from the positions of its endpoints, returns the third
+	static Point2 getCorners( Mesh const &mesh , uint32_t hedge , Point2 const &origin , Point2 const &end , Point2 aCorners[ 3 ] )
+	{
+		Point2 third = unfoldThird( mesh , hedge , origin , end );
+		uint32_t first = mesh.aFaceHalfEdge[ mesh.aHalfEdgeFace[ hedge ] ];
+		uint32_t next = mesh.aHalfEdgeNext[ hedge ];
+		Point2 aByHalfEdge[ 3 ] = { origin , end , third };
+		uint32_t current = first;
+		ito( 3 )
+		{
+			aCorners[ i ] = current == hedge ? aByHalfEdge[ 0 ] : current == next ? aByHalfEdge[ 1 ] : aByHalfEdge[ 2 ];
+			current = mesh.aHalfEdgeNext[ current ];
+		}
+		return third;
+	}
+	// corridor as returned by getCorridor, startPoint lies on its first face and endPoint on its last
+	void run( Mesh const &mesh , std::vector< uint32_t > const &corridor , float3 const &startPoint , float3 const &endPoint )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		aLeft.clear();
+		aRight.clear();
+		aPortalHalfEdge.clear();
+		aPath.clear();
+		aPathPortal.clear();
+		aCrossings.clear();
+		length = 0.0;
+		stats = CorridorFunnelStats();
+		if( corridor.empty() )
+		{
+			return;
+		}
+		Point2 aCorners[ 3 ];
+		if( corridor.size() == 1 )
+		{
+			uint32_t hedge = mesh.aFaceHalfEdge[ corridor[ 0 ] ];
+			getCorners( mesh , hedge , { 0.0 , 0.0 } , { mesh.getEdgeLength( hedge ) , 0.0 } , aCorners );
+			Point2 from = mapPoint( mesh , corridor[ 0 ] , startPoint , aCorners );
+			Point2 to = mapPoint( mesh , corridor[ 0 ] , endPoint , aCorners );
+			aPath = { from , to };
+			aPathPortal = { 0 , 0 };
+			length = startPoint.dist( endPoint );
+			stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			return;
+		}
+		// Unfold: each face is entered through the twin of the previous portal, which runs left -> right
+		uint32_t portalCount = uint32_t( corridor.size() ) - 1;
+		aLeft.resize( portalCount + 2 );
+		aRight.resize( portalCount + 2 );
+		aPortalHalfEdge.resize( portalCount );
+		uint32_t hedge = mesh.getSharedHalfEdge( corridor[ 0 ] , corridor[ 1 ] );
+		Point2 origin = { 0.0 , 0.0 } , end = { mesh.getEdgeLength( hedge ) , 0.0 };
+		getCorners( mesh , hedge , origin , end , aCorners );
+		aLeft[ 0 ] = aRight[ 0 ] = mapPoint( mesh , corridor[ 0 ] , startPoint , aCorners );
+		for( uint32_t i = 0; i < portalCount; i++ )
+		{
+			aPortalHalfEdge[ i ] = hedge;
+			aLeft[ i + 1 ] = end;
+			aRight[ i + 1 ] = origin;
+			uint32_t twin = mesh.aHalfEdgeTwin[ hedge ];
+			Point2 third = getCorners( mesh , twin , end , origin , aCorners );
+			if( i + 1 == portalCount )
+			{
+				break;
+			}
+			// The next portal leaves the entered face through one of the two edges at its third vertex
+			uint32_t next = mesh.getSharedHalfEdge( corridor[ i + 1 ] , corridor[ i + 2 ] );
+			if( next == mesh.aHalfEdgeNext[ twin ] )
+			{
+				end = third;
+			} else
+			{
+				origin = third;
+			}
+			hedge = next;
+		}
+		aLeft[ portalCount + 1 ] = aRight[ portalCount + 1 ] = mapPoint( mesh , corridor.back() , endPoint , aCorners );
+		// Funnel over the portals, restarting from the apex whenever one side crosses the other
+		uint32_t last = portalCount + 1;
+		Point2 apex = aLeft[ 0 ] , left = aLeft[ 0 ] , right = aRight[ 0 ];
+		uint32_t apexIndex = 0 , leftIndex = 0 , rightIndex = 0;
+		aPath.push_back( apex );
+		aPathPortal.push_back( 0 );
+		// A vertex shared by consecutive portals can become the apex again, it keeps its latest portal
+		auto pushApex = [ & ]()
+		{
+			if( equal( aPath.back() , apex ) )
+			{
+				aPathPortal.back() = apexIndex;
+			} else
+			{
+				aPath.push_back( apex );
+				aPathPortal.push_back( apexIndex );
+			}
+		};
+		for( uint32_t i = 1; i <= last; i++ )
+		{
+			Point2 const &newLeft = aLeft[ i ];
+			Point2 const &newRight = aRight[ i ];
+			if( cross( apex , right , newRight ) >= 0.0 )
+			{
+				if( equal( apex , right ) || cross( apex , left , newRight ) < 0.0 )
+				{
+					right = newRight;
+					rightIndex = i;
+				} else
+				{
+					apex = left;
+					apexIndex = leftIndex;
+					pushApex();
+					left = right = apex;
+					rightIndex = apexIndex;
+					i = apexIndex;
+					continue;
+				}
+			}
+			if( cross( apex , left , newLeft ) <= 0.0 )
+			{
+				if( equal( apex , left ) || cross( apex , right , newLeft ) > 0.0 )
+				{
+					left = newLeft;
+					leftIndex = i;
+				} else
+				{
+					apex = right;
+					apexIndex = rightIndex;
+					pushApex();
+					left = right = apex;
+					leftIndex = apexIndex;
+					i = apexIndex;
+					continue;
+				}
+			}
+		}
+		if( !equal( aPath.back() , aLeft[ last ] ) || aPathPortal.back() != last )
+		{
+			aPath.push_back( aLeft[ last ] );
+			aPathPortal.push_back( last );
+		}
+		for( size_t i = 0; i + 1 < aPath.size(); i++ )
+		{
+			length += hypot( aPath[ i + 1 ].x - aPath[ i ].x , aPath[ i + 1 ].y - aPath[ i ].y );
+		}
+		// Crossing of each portal by the path segment spanning it
+		aCrossings.resize( portalCount );
+		size_t segment = 0;
+		for( uint32_t i = 1; i <= portalCount; i++ )
+		{
+			while( aPathPortal[ segment + 1 ] < i )
+			{
+				segment++;
+			}
+			Point2 const &a = aPath[ segment ] , &b = aPath[ segment + 1 ];
+			Point2 const &r = aRight[ i ] , &l = aLeft[ i ];
+			double ex = l.x - r.x , ey = l.y - r.y;
+			double dx = b.x - a.x , dy = b.y - a.y;
+			double denom = ex * dy - ey * dx;
+			double s;
+			if( fabs( denom ) > 1e-12 * ( ex * ex + ey * ey ) )
+			{
+				s = ( ( a.x - r.x ) * dy - ( a.y - r.y ) * dx ) / denom;
+			} else
+			{
+				s = ( ( a.x - r.x ) * ex + ( a.y - r.y ) * ey ) / ( ex * ex + ey * ey );
+			}
+			s = s < 0.0 ? 0.0 : s > 1.0 ? 1.0 : s;
+			aCrossings[ i - 1 ] = float( s ) * mesh.getEdgeLength( aPortalHalfEdge[ i - 1 ] );
+		}
+		stats.portals = portalCount;
+		stats.apexes = uint32_t( aPath.size() ) - 2;
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Surface polyline from the start point through every portal crossing to the end point
+	void getPath( Mesh const &mesh , float3 const &startPoint , float3 const &endPoint , std::vector< float3 > &path ) const
+	{
+		path.clear();
+		path.push_back( startPoint );
+		for( size_t i = 0; i < aCrossings.size(); i++ )
+		{
+			path.push_back( mesh.getOrigin( aPortalHalfEdge[ i ] ) + mesh.getEdgeNormal( aPortalHalfEdge[ i ] ) * aCrossings[ i ] );
+		}
+		path.push_back( endPoint );
+	}
+};
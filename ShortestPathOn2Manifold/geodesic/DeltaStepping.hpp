@@ -0,0 +1,260 @@
+#pragma once
+#include "geodesic/FaceSearch.hpp"
+#include <atomic>
+#include <chrono>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+struct DeltaSteppingStats
+{
+	uint32_t buckets = 0;
+	uint32_t phases = 0;
+	// Phases and closing relaxations whose frontier was large enough to run on every thread
+	uint32_t parallelPhases = 0;
+	uint64_t relaxations = 0;
+	uint64_t improvements = 0;
+	uint32_t threads = 0;
+	float delta = 0.0f;
+	double seconds = 0.0;
+};
+// Full distance field from one source point by delta-stepping. Faces are kept in buckets of width
+// delta by tentative distance. The lowest bucket is emptied in phases that relax the light arcs of
+// all its faces in parallel, re-queuing faces that stay in the bucket. The heavy arcs of everything
+// the bucket settled are relaxed once at the end. Labels pack the distance bits above the parent
+// face, and non-negative floats order like their bit patterns, so one 64 bit CAS loop is an atomic
+// min on both. Every label ends at the smallest float path sum, the same value the serial flood
+// reaches, and ties keep the lowest parent face, so the output does not depend on the schedule.
+struct DeltaStepping
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	// Bucket width, 0 picks four times the mean arc weight
+	float delta = 0.0f;
+	// 0 uses every OpenMP thread
+	int threadCount = 0;
+	// Smaller frontiers are relaxed on the calling thread, a parallel region costs more than their work
+	uint32_t minParallelFrontier = 2048;
+	std::vector< std::atomic< uint64_t > > aLabels;
+	// Bucket a face was last queued in, NONE once a phase has taken it out
+	std::vector< std::atomic< uint32_t > > aQueued;
+	// Buckets of each thread, merged into the frontier at the start of a phase
+	std::vector< std::vector< std::vector< uint32_t > > > aThreadBuckets;
+	std::vector< std::vector< uint32_t > > aThreadSettled;
+	std::vector< uint32_t > aFrontier;
+	std::vector< uint32_t > aSettled;
+	SearchEndpoints endpoints;
+	DeltaSteppingStats stats;
+	static uint64_t pack( float dist , uint32_t from )
+	{
+		uint32_t bits;
+		memcpy( &bits , &dist , 4 );
+		return uint64_t( bits ) << 32 | from;
+	}
+	// FLT_MAX for faces the source does not reach
+	float getDistance( uint32_t face ) const
+	{
+		uint32_t bits = uint32_t( aLabels[ face ].load( std::memory_order_relaxed ) >> 32 );
+		float dist;
+		memcpy( &dist , &bits , 4 );
+		return dist;
+	}
+	uint32_t getFrom( uint32_t face ) const
+	{
+		return uint32_t( aLabels[ face ].load( std::memory_order_relaxed ) );
+	}
+	static bool atomicMin( std::atomic< uint64_t > &label , uint64_t value )
+	{
+		uint64_t current = label.load( std::memory_order_relaxed );
+		while( value < current )
+		{
+			if( label.compare_exchange_weak( current , value ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	static float getDefaultDelta( DualGraph const &graph )
+	{
+		double sum = 0.0;
+		for( uint32_t arc = 0; arc < graph.getArcCount(); arc++ )
+		{
+			sum += graph.aArcWeight[ arc ];
+		}
+		return graph.getArcCount() ? float( 4.0 * sum / graph.getArcCount() ) : 1.0f;
+	}
+	void run( DualGraph const &graph , uint32_t sourceFace , float3 const &sourcePoint )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		stats = DeltaSteppingStats();
+#ifdef _OPENMP
+		int threads = threadCount > 0 ? threadCount : omp_get_max_threads();
+#else
+		int threads = 1;
+#endif
+		stats.threads = uint32_t( threads );
+		stats.delta = delta > 0.0f ? delta : getDefaultDelta( graph );
+		endpoints = SearchEndpoints();
+		endpoints.sourceFace = sourceFace;
+		endpoints.sourcePoint = sourcePoint;
+		int faceCount = int( graph.getFaceCount() );
+		if( aLabels.size() != size_t( faceCount ) )
+		{
+			std::vector< std::atomic< uint64_t > >( faceCount ).swap( aLabels );
+			std::vector< std::atomic< uint32_t > >( faceCount ).swap( aQueued );
+		}
+		uint64_t unreached = pack( FLT_MAX , Mesh::INVALID );
+#pragma omp parallel for num_threads( threads )
+		for( int face = 0; face < faceCount; face++ )
+		{
+			aLabels[ face ].store( unreached , std::memory_order_relaxed );
+			aQueued[ face ].store( NONE , std::memory_order_relaxed );
+		}
+		aThreadBuckets.resize( threads );
+		aThreadSettled.resize( threads );
+		for( auto &aBuckets : aThreadBuckets )
+		{
+			aBuckets.clear();
+		}
+		aLabels[ sourceFace ].store( pack( 0.0f , Mesh::INVALID ) );
+		aQueued[ sourceFace ].store( 0 );
+		aThreadBuckets[ 0 ].resize( 1 );
+		aThreadBuckets[ 0 ][ 0 ].push_back( sourceFace );
+		for( uint32_t bucket = 0; gatherFrontier( bucket ); bucket++ )
+		{
+			stats.buckets++;
+			aSettled.clear();
+			while( !aFrontier.empty() )
+			{
+				stats.phases++;
+				relaxFrontier( graph , bucket , threads , true );
+				for( auto &aThreadSettledFaces : aThreadSettled )
+				{
+					aSettled.insert( aSettled.end() , aThreadSettledFaces.begin() , aThreadSettledFaces.end() );
+				}
+				gatherFrontier( bucket , false );
+			}
+			aFrontier.swap( aSettled );
+			relaxFrontier( graph , bucket , threads , false );
+			aFrontier.clear();
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Moves the queued faces of the lowest non-empty bucket from bucket on into the frontier.
+	// Without skip only that exact bucket is taken. Returns false if nothing is queued.
+	bool gatherFrontier( uint32_t &bucket , bool skip = true )
+	{
+		aFrontier.clear();
+		if( skip )
+		{
+			uint32_t next = NONE;
+			for( auto const &aBuckets : aThreadBuckets )
+			{
+				for( uint32_t i = bucket; i < aBuckets.size() && i < next; i++ )
+				{
+					if( !aBuckets[ i ].empty() )
+					{
+						next = i;
+						break;
+					}
+				}
+			}
+			if( next == NONE )
+			{
+				return false;
+			}
+			bucket = next;
+		}
+		for( auto &aBuckets : aThreadBuckets )
+		{
+			if( bucket < aBuckets.size() )
+			{
+				aFrontier.insert( aFrontier.end() , aBuckets[ bucket ].begin() , aBuckets[ bucket ].end() );
+				aBuckets[ bucket ].clear();
+			}
+		}
+		return !aFrontier.empty();
+	}
+	// Light arcs of the frontier while the bucket is open, heavy arcs of its settled faces once it closes
+	void relaxFrontier( DualGraph const &graph , uint32_t bucket , int threads , bool light )
+	{
+		float delta = stats.delta;
+		int frontierSize = int( aFrontier.size() );
+		bool parallel = threads > 1 && aFrontier.size() >= minParallelFrontier;
+		stats.parallelPhases += parallel;
+		for( auto &aSettledFaces : aThreadSettled )
+		{
+			aSettledFaces.clear();
+		}
+		uint64_t relaxations = 0 , improvements = 0;
+#pragma omp parallel if( parallel ) num_threads( threads ) reduction( + : relaxations , improvements )
+		{
+#ifdef _OPENMP
+			int thread = omp_get_thread_num();
+#else
+			int thread = 0;
+#endif
+			std::vector< std::vector< uint32_t > > &aBuckets = aThreadBuckets[ thread ];
+			std::vector< uint32_t > &aSettledFaces = aThreadSettled[ thread ];
+#pragma omp for schedule( dynamic , 64 )
+			for( int i = 0; i < frontierSize; i++ )
+			{
+				uint32_t face = aFrontier[ i ];
+				if( light )
+				{
+					// Taken out before its distance is read, a later improvement queues it again
+					aQueued[ face ].store( NONE );
+				}
+				float faceDist = getDistance( face );
+				// Stale entry of a face that was improved into an earlier bucket
+				if( uint32_t( faceDist / delta ) != bucket )
+				{
+					continue;
+				}
+				if( light )
+				{
+					aSettledFaces.push_back( face );
+				}
+				for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+				{
+					float weight = endpoints.getArcWeight( graph , face , arc );
+					if( ( weight <= delta ) != light )
+					{
+						continue;
+					}
+					relaxations++;
+					uint32_t adjFace = graph.aArcFace[ arc ];
+					float dist = faceDist + weight;
+					if( atomicMin( aLabels[ adjFace ] , pack( dist , face ) ) )
+					{
+						improvements++;
+						uint32_t adjBucket = uint32_t( dist / delta );
+						if( aQueued[ adjFace ].exchange( adjBucket ) != adjBucket )
+						{
+							if( aBuckets.size() <= adjBucket )
+							{
+								aBuckets.resize( adjBucket + 1 );
+							}
+							aBuckets[ adjBucket ].push_back( adjFace );
+						}
+					}
+				}
+			}
+		}
+		stats.relaxations += relaxations;
+		stats.improvements += improvements;
+	}
+	// Faces from face back to the source
+	void getCorridor( uint32_t face , std::vector< uint32_t > &aCorridor ) const
+	{
+		aCorridor.clear();
+		if( getDistance( face ) == FLT_MAX )
+		{
+			return;
+		}
+		for( ; face != Mesh::INVALID; face = getFrom( face ) )
+		{
+			aCorridor.push_back( face );
+		}
+	}
+};
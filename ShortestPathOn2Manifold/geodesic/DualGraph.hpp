@@ -0,0 +1,92 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <vector>
+// Face adjacency graph in CSR form. Arcs of face f are [ aOffsets[ f ] , aOffsets[ f + 1 ] ),
+// each arc crosses one half-edge of f and weighs |center( f ) - mid| + |mid - center( adj )|.
+struct DualGraph
+{
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	std::vector< uint32_t > aOffsets;
+	std::vector< uint32_t > aArcFace;
+	std::vector< uint32_t > aArcHalfEdge;
+	std::vector< float > aArcWeight;
+	std::vector< float3 > aArcMid;
+	std::vector< float3 > aFaceCenter;
+	uint32_t getFaceCount() const
+	{
+		return uint32_t( aFaceCenter.size() );
+	}
+	uint32_t getArcCount() const
+	{
+		return uint32_t( aArcFace.size() );
+	}
+	// Weight of an arc for a path running from -> edge midpoint -> to
+	float getArcWeight( uint32_t arc , float3 const &from , float3 const &to ) const
+	{
+		return aArcMid[ arc ].dist( from ) + to.dist( aArcMid[ arc ] );
+	}
+	bool isValid( Mesh const &mesh ) const
+	{
+		return pMesh == &mesh && meshVersion == mesh.version;
+	}
+	// Rebuilds only if the mesh has been reloaded since the last build
+	void update( Mesh const &mesh )
+	{
+		if( !isValid( mesh ) )
+		{
+			build( mesh );
+		}
+	}
+	void build( Mesh const &mesh )
+	{
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		int faceCount = int( mesh.getFaceCount() );
+		aFaceCenter.resize( faceCount );
+		aOffsets.resize( faceCount + 1 );
+#pragma omp parallel for
+		for( int face = 0; face < faceCount; face++ )
+		{
+			aFaceCenter[ face ] = mesh.getFaceCenter( face );
+			uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+			uint32_t arcCount = 0;
+			ito( 3 )
+			{
+				arcCount += mesh.aHalfEdgeTwin[ hedge ] != Mesh::INVALID;
+				hedge = mesh.aHalfEdgeNext[ hedge ];
+			}
+			aOffsets[ face + 1 ] = arcCount;
+		}
+		aOffsets[ 0 ] = 0;
+		for( int face = 0; face < faceCount; face++ )
+		{
+			aOffsets[ face + 1 ] += aOffsets[ face ];
+		}
+		uint32_t arcCount = aOffsets[ faceCount ];
+		aArcFace.resize( arcCount );
+		aArcHalfEdge.resize( arcCount );
+		aArcWeight.resize( arcCount );
+		aArcMid.resize( arcCount );
+#pragma omp parallel for
+		for( int face = 0; face < faceCount; face++ )
+		{
+			uint32_t arc = aOffsets[ face ];
+			uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+			ito( 3 )
+			{
+				uint32_t adjFace = mesh.getAdjacentFace( hedge );
+				if( adjFace != Mesh::INVALID )
+				{
+					float3 mid = mesh.getEdgeCenter( hedge );
+					aArcFace[ arc ] = adjFace;
+					aArcHalfEdge[ arc ] = hedge;
+					aArcMid[ arc ] = mid;
+					aArcWeight[ arc ] = getArcWeight( arc , aFaceCenter[ face ] , mesh.getFaceCenter( adjFace ) );
+					arc++;
+				}
+				hedge = mesh.aHalfEdgeNext[ hedge ];
+			}
+		}
+	}
+};
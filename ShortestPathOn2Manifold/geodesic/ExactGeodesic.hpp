@@ -0,0 +1,621 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <float.h>
+#include <math.h>
+#include <chrono>
+#include <queue>
+#include <functional>
+struct ExactGeodesicStats
+{
+	uint32_t windowsCreated = 0;
+	uint32_t windowsPropagated = 0;
+	uint32_t windowsPruned = 0;
+	uint32_t vertexSources = 0;
+	double seconds = 0.0;
+};
+// Exact polyhedral geodesic distance by window propagation (Chen-Han with the Xin-Wang improvements).
+// A window is an interval of a half-edge through which straight unfolded rays from a pseudo-source
+// enter the half-edge's face. Windows and saddle/boundary vertex events are processed in order of
+// their minimal distance, and a window is dropped as soon as either endpoint vertex of its edge
+// reaches the whole interval along the edge at least as fast. Within a face, rays crossing the
+// shortest known segment from the entry edge to the opposite vertex are cut as well (the "one
+// angle one split" filter): past the crossing that segment's path is always shorter.
+struct ExactGeodesic
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	static constexpr double PI = 3.14159265358979323846;
+	struct Window
+	{
+		// Half-edge of the face the window propagates into, parameters are measured from its origin
+		uint32_t hedge;
+		uint32_t nextOnEdge;
+		// Window it was cut from, NONE when it starts at a pseudo-source
+		uint32_t parent;
+		// Pseudo-source vertex, NONE for the picked point
+		uint32_t sourceVertex;
+		double b0 , b1;
+		// Pseudo-source in the half-edge frame, x along the half-edge and y >= 0 away from the face
+		double sx , sy;
+		double sigma;
+		double getDistance( double x ) const
+		{
+			return sigma + sqrt( ( x - sx ) * ( x - sx ) + sy * sy );
+		}
+		double getMinDistance() const
+		{
+			return sx < b0 ? getDistance( b0 ) : sx > b1 ? getDistance( b1 ) : sigma + sy;
+		}
+	};
+	struct Event
+	{
+		double key;
+		uint32_t id;
+		bool isVertex;
+		bool operator>( Event const &event ) const
+		{
+			return key > event.key;
+		}
+	};
+	struct Frame
+	{
+		float3 origin , axis;
+		double length;
+		double cx , cy;
+	};
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	double tolerance = 0.0;
+	std::vector< uint32_t > aVertexOffsets;
+	std::vector< uint32_t > aVertexHalfEdges;
+	std::vector< uint8_t > aPseudoSource;
+	std::vector< uint8_t > aBoundary;
+	std::vector< double > aVertexAngle;
+	// Angle at the origin of each half-edge inside its face
+	std::vector< double > aCornerAngle;
+	std::vector< Window > aWindows;
+	std::vector< uint32_t > aHalfEdgeWindows;
+	std::vector< double > aVertexDist;
+	std::vector< uint32_t > aVertexFromWindow;
+	std::vector< uint32_t > aVertexFromVertex;
+	// Per half-edge, the shortest split of a window at the opposite vertex and where its ray crosses the half-edge
+	std::vector< double > aSplitDist;
+	std::vector< double > aSplitX;
+	std::priority_queue< Event , std::vector< Event > , std::greater< Event > > eventQ;
+	uint32_t sourceFace = Mesh::INVALID;
+	float3 sourcePoint;
+	uint32_t targetFace = Mesh::INVALID;
+	float3 targetPoint;
+	double targetDist = DBL_MAX;
+	ExactGeodesicStats stats;
+	static double dot( float3 const &a , float3 const &b )
+	{
+		return double( a.x ) * b.x + double( a.y ) * b.y + double( a.z ) * b.z;
+	}
+	void update( Mesh const &mesh )
+	{
+		if( pMesh != &mesh || meshVersion != mesh.version )
+		{
+			build( mesh );
+		}
+	}
+	// Outgoing half-edges per vertex and the vertices geodesics may bend around
+	void build( Mesh const &mesh )
+	{
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		uint32_t vertexCount = mesh.getVertexCount();
+		uint32_t hedgeCount = mesh.getHalfEdgeCount();
+		aVertexOffsets.assign( vertexCount + 1 , 0 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexOffsets[ mesh.aHalfEdgeOrigin[ hedge ] + 1 ]++;
+		}
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aVertexOffsets[ vertex + 1 ] += aVertexOffsets[ vertex ];
+		}
+		aVertexHalfEdges.resize( hedgeCount );
+		std::vector< uint32_t > aFill( aVertexOffsets.begin() , aVertexOffsets.end() - 1 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexHalfEdges[ aFill[ mesh.aHalfEdgeOrigin[ hedge ] ]++ ] = hedge;
+		}
+		float3 minPos( FLT_MAX ) , maxPos( -FLT_MAX );
+		for( auto const &pos : mesh.aPositions )
+		{
+			ito( 3 )
+			{
+				minPos[ i ] = fminf( minPos[ i ] , pos[ i ] );
+				maxPos[ i ] = fmaxf( maxPos[ i ] , pos[ i ] );
+			}
+		}
+		tolerance = vertexCount ? maxPos.dist( minPos ) * 1.0e-6 : 0.0;
+		aPseudoSource.assign( vertexCount , 0 );
+		aBoundary.assign( vertexCount , 0 );
+		aVertexAngle.assign( vertexCount , 0.0 );
+		aCornerAngle.resize( hedgeCount );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			uint32_t prev = mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ];
+			float3 const &origin = mesh.getOrigin( hedge );
+			float3 e0 = mesh.aPositions[ mesh.getEnd( hedge ) ] - origin;
+			float3 e1 = mesh.getOrigin( prev ) - origin;
+			double cosAngle = dot( e0 , e1 ) / sqrt( dot( e0 , e0 ) * dot( e1 , e1 ) );
+			aCornerAngle[ hedge ] = acos( cosAngle < -1.0 ? -1.0 : cosAngle > 1.0 ? 1.0 : cosAngle );
+			aVertexAngle[ mesh.aHalfEdgeOrigin[ hedge ] ] += aCornerAngle[ hedge ];
+			if( mesh.aHalfEdgeTwin[ hedge ] == Mesh::INVALID )
+			{
+				aBoundary[ mesh.aHalfEdgeOrigin[ hedge ] ] = 1;
+				aBoundary[ mesh.getEnd( hedge ) ] = 1;
+			}
+		}
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aPseudoSource[ vertex ] = aBoundary[ vertex ] || aVertexAngle[ vertex ] > 2.0 * PI + 1.0e-6;
+		}
+	}
+	// Half-edge frame: origin of the half-edge at 0, its end at ( length , 0 ), the third vertex at ( cx , cy ) with cy <= 0
+	Frame getFrame( uint32_t hedge ) const
+	{
+		Mesh const &mesh = *pMesh;
+		Frame frame;
+		frame.origin = mesh.getOrigin( hedge );
+		float3 edge = mesh.aPositions[ mesh.getEnd( hedge ) ] - frame.origin;
+		frame.length = sqrt( dot( edge , edge ) );
+		frame.axis = edge / float( frame.length );
+		float3 third = mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ) - frame.origin;
+		frame.cx = dot( third , frame.axis );
+		double cy2 = dot( third , third ) - frame.cx * frame.cx;
+		frame.cy = -sqrt( cy2 > 0.0 ? cy2 : 0.0 );
+		return frame;
+	}
+	// Coordinates of a point lying in the half-edge's face
+	void toFrame( Frame const &frame , float3 const &point , double &x , double &y ) const
+	{
+		float3 rel = point - frame.origin;
+		x = dot( rel , frame.axis );
+		double y2 = dot( rel , rel ) - x * x;
+		y = -sqrt( y2 > 0.0 ? y2 : 0.0 );
+	}
+	bool updateVertex( uint32_t vertex , double dist , uint32_t fromWindow , uint32_t fromVertex )
+	{
+		if( dist >= aVertexDist[ vertex ] )
+		{
+			return false;
+		}
+		aVertexDist[ vertex ] = dist;
+		aVertexFromWindow[ vertex ] = fromWindow;
+		aVertexFromVertex[ vertex ] = fromVertex;
+		if( aPseudoSource[ vertex ] )
+		{
+			eventQ.push( { dist , vertex , true } );
+		}
+		if( targetFace != Mesh::INVALID )
+		{
+			uint32_t hedge = pMesh->aFaceHalfEdge[ targetFace ];
+			ito( 3 )
+			{
+				if( pMesh->aHalfEdgeOrigin[ hedge ] == vertex )
+				{
+					double candidate = dist + pMesh->aPositions[ vertex ].dist( targetPoint );
+					targetDist = candidate < targetDist ? candidate : targetDist;
+				}
+				hedge = pMesh->aHalfEdgeNext[ hedge ];
+			}
+		}
+		return true;
+	}
+	bool isPruned( Window const &window ) const
+	{
+		Mesh const &mesh = *pMesh;
+		double length = mesh.getEdgeLength( window.hedge );
+		double dOrigin = aVertexDist[ mesh.aHalfEdgeOrigin[ window.hedge ] ];
+		double dEnd = aVertexDist[ mesh.getEnd( window.hedge ) ];
+		return dOrigin + window.b1 < window.getDistance( window.b1 ) - tolerance
+			|| dEnd + ( length - window.b0 ) < window.getDistance( window.b0 ) - tolerance;
+	}
+	double getWindowDistance( Window const &window , float3 const &point ) const
+	{
+		Frame frame = getFrame( window.hedge );
+		double x , y;
+		toFrame( frame , point , x , y );
+		double denom = window.sy - y;
+		double cross = denom > 0.0 ? window.sx + ( x - window.sx ) * window.sy / denom : x;
+		if( cross < window.b0 - tolerance || cross > window.b1 + tolerance )
+		{
+			return DBL_MAX;
+		}
+		return window.sigma + sqrt( ( x - window.sx ) * ( x - window.sx ) + ( y - window.sy ) * ( y - window.sy ) );
+	}
+	void addWindow( Window const &window )
+	{
+		if( isPruned( window ) )
+		{
+			stats.windowsPruned++;
+			return;
+		}
+		uint32_t id = uint32_t( aWindows.size() );
+		aWindows.push_back( window );
+		aWindows[ id ].nextOnEdge = aHalfEdgeWindows[ window.hedge ];
+		aHalfEdgeWindows[ window.hedge ] = id;
+		stats.windowsCreated++;
+		eventQ.push( { window.getMinDistance() , id , false } );
+		if( targetFace != Mesh::INVALID && pMesh->aHalfEdgeFace[ window.hedge ] == targetFace )
+		{
+			double candidate = getWindowDistance( window , targetPoint );
+			targetDist = candidate < targetDist ? candidate : targetDist;
+		}
+	}
+	// Window on the twin of faceHedge with a pseudo-source given in the frame of faceHedge's face
+	void addChildWindow( uint32_t faceHedge , double px , double py , double qx , double qy ,
+		double mu0 , double mu1 , double sx , double sy , double sigma , uint32_t parent , uint32_t sourceVertex )
+	{
+		Mesh const &mesh = *pMesh;
+		double ex = px - qx , ey = py - qy;
+		double length = sqrt( ex * ex + ey * ey );
+		if( length <= 0.0 )
+		{
+			return;
+		}
+		ex /= length;
+		ey /= length;
+		double b0 = ( 1.0 - mu1 ) * length;
+		double b1 = ( 1.0 - mu0 ) * length;
+		double childSx = ( sx - qx ) * ex + ( sy - qy ) * ey;
+		double childSy = fabs( ( sx - qx ) * ey - ( sy - qy ) * ex );
+		uint32_t origin = mesh.getEnd( faceHedge );
+		uint32_t end = mesh.aHalfEdgeOrigin[ faceHedge ];
+		uint32_t fromWindow = parent;
+		uint32_t fromVertex = parent == NONE ? sourceVertex : NONE;
+		if( b0 <= tolerance )
+		{
+			updateVertex( origin , sigma + sqrt( childSx * childSx + childSy * childSy ) , fromWindow , fromVertex );
+		}
+		if( b1 >= length - tolerance )
+		{
+			updateVertex( end , sigma + sqrt( ( length - childSx ) * ( length - childSx ) + childSy * childSy ) , fromWindow , fromVertex );
+		}
+		uint32_t twin = mesh.aHalfEdgeTwin[ faceHedge ];
+		if( twin == Mesh::INVALID || b1 - b0 <= tolerance * 1.0e-3 )
+		{
+			return;
+		}
+		Window window;
+		window.hedge = twin;
+		window.parent = parent;
+		window.sourceVertex = sourceVertex;
+		window.b0 = b0 > 0.0 ? b0 : 0.0;
+		window.b1 = b1 < length ? b1 : length;
+		window.sx = childSx;
+		window.sy = childSy;
+		window.sigma = sigma;
+		addWindow( window );
+	}
+	void propagate( uint32_t id )
+	{
+		Mesh const &mesh = *pMesh;
+		Window window = aWindows[ id ];
+		Frame frame = getFrame( window.hedge );
+		if( window.sy <= tolerance * 1.0e-3 )
+		{
+			return;
+		}
+		stats.windowsPropagated++;
+		uint32_t hedgeBC = mesh.aHalfEdgeNext[ window.hedge ];
+		uint32_t hedgeCA = mesh.aHalfEdgeNext[ hedgeBC ];
+		double L = frame.length , cx = frame.cx , cy = frame.cy;
+		// Where the ray from the pseudo-source through the opposite vertex crosses the window's edge
+		double xC = window.sx + ( cx - window.sx ) * window.sy / ( window.sy - cy );
+		double dC = window.sigma + sqrt( ( cx - window.sx ) * ( cx - window.sx ) + ( cy - window.sy ) * ( cy - window.sy ) );
+		double leftEnd = window.b1 , rightStart = window.b0;
+		if( dC > aSplitDist[ window.hedge ] + tolerance )
+		{
+			leftEnd = aSplitX[ window.hedge ] < window.b1 ? aSplitX[ window.hedge ] : window.b1;
+			rightStart = aSplitX[ window.hedge ] > window.b0 ? aSplitX[ window.hedge ] : window.b0;
+		} else if( xC >= window.b0 && xC <= window.b1 )
+		{
+			updateVertex( mesh.aHalfEdgeOrigin[ hedgeCA ] , dC , id , NONE );
+			if( dC < aSplitDist[ window.hedge ] )
+			{
+				aSplitDist[ window.hedge ] = dC;
+				aSplitX[ window.hedge ] = xC;
+			}
+		}
+		// Parameter along P -> Q hit by the ray through ( x , 0 )
+		auto project = [ & ]( double x , double px , double py , double qx , double qy )
+		{
+			double dx = x - window.sx , dy = -window.sy;
+			double denom = ( qx - px ) * dy - ( qy - py ) * dx;
+			double mu = denom != 0.0 ? ( ( window.sx - px ) * dy - ( window.sy - py ) * dx ) / denom : 0.0;
+			return mu < 0.0 ? 0.0 : mu > 1.0 ? 1.0 : mu;
+		};
+		double x0 = window.b0 , x1 = xC < leftEnd ? xC : leftEnd;
+		if( x0 < x1 )
+		{
+			double mu0 = project( x0 , cx , cy , 0.0 , 0.0 ) , mu1 = project( x1 , cx , cy , 0.0 , 0.0 );
+			addChildWindow( hedgeCA , cx , cy , 0.0 , 0.0 , mu0 < mu1 ? mu0 : mu1 , mu0 < mu1 ? mu1 : mu0 ,
+				window.sx , window.sy , window.sigma , id , window.sourceVertex );
+		}
+		x0 = xC > rightStart ? xC : rightStart;
+		x1 = window.b1;
+		if( x0 < x1 )
+		{
+			double mu0 = project( x0 , L , 0.0 , cx , cy ) , mu1 = project( x1 , L , 0.0 , cx , cy );
+			addChildWindow( hedgeBC , L , 0.0 , cx , cy , mu0 < mu1 ? mu0 : mu1 , mu0 < mu1 ? mu1 : mu0 ,
+				window.sx , window.sy , window.sigma , id , window.sourceVertex );
+		}
+	}
+	// Angle around the vertex, measured from its outgoing half-edge first, of the direction back
+	// along the path that reached it. 0, as for a boundary vertex, if the path reached it from a
+	// vertex it shares no face with.
+	double getArrivalAngle( uint32_t vertex , uint32_t first ) const
+	{
+		Mesh const &mesh = *pMesh;
+		float3 const &pos = mesh.aPositions[ vertex ];
+		uint32_t face = Mesh::INVALID;
+		float3 back;
+		if( aVertexFromWindow[ vertex ] != NONE )
+		{
+			Window const &window = aWindows[ aVertexFromWindow[ vertex ] ];
+			Frame frame = getFrame( window.hedge );
+			float3 third = mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ window.hedge ] ] ) - frame.origin;
+			float3 away = ( frame.axis * float( frame.cx ) - third ).norm();
+			face = mesh.aHalfEdgeFace[ window.hedge ];
+			back = frame.origin + frame.axis * float( window.sx ) + away * float( window.sy ) - pos;
+		} else if( aVertexFromVertex[ vertex ] != NONE )
+		{
+			uint32_t from = aVertexFromVertex[ vertex ];
+			for( uint32_t i = aVertexOffsets[ vertex ]; i < aVertexOffsets[ vertex + 1 ]; i++ )
+			{
+				if( mesh.getEnd( aVertexHalfEdges[ i ] ) == from )
+				{
+					face = mesh.aHalfEdgeFace[ aVertexHalfEdges[ i ] ];
+					break;
+				}
+			}
+			if( face == Mesh::INVALID )
+			{
+				return 0.0;
+			}
+			back = mesh.aPositions[ from ] - pos;
+		} else
+		{
+			face = sourceFace;
+			back = sourcePoint - pos;
+		}
+		double angle = 0.0;
+		uint32_t hedge = first;
+		while( mesh.aHalfEdgeFace[ hedge ] != face )
+		{
+			angle += aCornerAngle[ hedge ];
+			hedge = mesh.aHalfEdgeTwin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ];
+		}
+		// Signed angle from the face's outgoing edge toward its incoming one
+		float3 edge = ( mesh.aPositions[ mesh.getEnd( hedge ) ] - pos ).norm();
+		float3 other = mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ) - pos;
+		float3 side = ( other - edge * float( dot( other , edge ) ) ).norm();
+		return angle + atan2( dot( back , side ) , dot( back , edge ) );
+	}
+	// Saddle or boundary vertex becomes a pseudo-source for the edges opposite to it. Around an interior
+	// saddle geodesics only continue through the vertex in directions turning at least pi away from
+	// the arrival direction on both sides, the rest is covered by the rays passing by it.
+	void emitVertex( uint32_t vertex )
+	{
+		Mesh const &mesh = *pMesh;
+		stats.vertexSources++;
+		double sigma = aVertexDist[ vertex ];
+		float3 const &pos = mesh.aPositions[ vertex ];
+		bool boundary = aBoundary[ vertex ] != 0;
+		uint32_t hedge = aVertexHalfEdges[ aVertexOffsets[ vertex ] ];
+		double total = aVertexAngle[ vertex ];
+		double arrival = boundary ? 0.0 : getArrivalAngle( vertex , hedge );
+		double shadowBegin = PI - 1.0e-5 , shadowEnd = total - PI + 1.0e-5;
+		double angle = 0.0;
+		for( uint32_t i = aVertexOffsets[ vertex ]; i < aVertexOffsets[ vertex + 1 ]; i++ )
+		{
+			if( boundary )
+			{
+				hedge = aVertexHalfEdges[ i ];
+			}
+			uint32_t opposite = mesh.aHalfEdgeNext[ hedge ];
+			double corner = aCornerAngle[ hedge ];
+			updateVertex( mesh.aHalfEdgeOrigin[ opposite ] , sigma + pos.dist( mesh.getOrigin( opposite ) ) , NONE , vertex );
+			updateVertex( mesh.getEnd( opposite ) , sigma + pos.dist( mesh.aPositions[ mesh.getEnd( opposite ) ] ) , NONE , vertex );
+			// Opposite edge seen from its own face frame, the vertex sits at ( cx , cy )
+			Frame frame = getFrame( opposite );
+			if( boundary )
+			{
+				addChildWindow( opposite , 0.0 , 0.0 , frame.length , 0.0 , 0.0 , 1.0 , frame.cx , frame.cy , sigma , NONE , vertex );
+			} else
+			{
+				// The wedge may wrap past the arrival direction, test both of its copies against the shadow
+				double wedgeBegin = fmod( angle - arrival + 2.0 * total , total );
+				double sideLength = sqrt( frame.cx * frame.cx + frame.cy * frame.cy );
+				double originAngle = aCornerAngle[ opposite ];
+				for( double shift : { 0.0 , total } )
+				{
+					double a0 = fmax( wedgeBegin - shift , shadowBegin ) - ( wedgeBegin - shift );
+					double a1 = fmin( wedgeBegin - shift + corner , shadowEnd ) - ( wedgeBegin - shift );
+					if( a0 <= a1 )
+					{
+						// Law of sines in the triangle vertex, opposite origin, hit point
+						double mu0 = a0 <= 0.0 ? 0.0 : sideLength * sin( a0 ) / sin( a0 + originAngle ) / frame.length;
+						double mu1 = a1 >= corner ? 1.0 : sideLength * sin( a1 ) / sin( a1 + originAngle ) / frame.length;
+						addChildWindow( opposite , 0.0 , 0.0 , frame.length , 0.0 , fmax( mu0 , 0.0 ) , fmin( mu1 , 1.0 ) ,
+							frame.cx , frame.cy , sigma , NONE , vertex );
+					}
+				}
+			}
+			angle += corner;
+			hedge = mesh.aHalfEdgeTwin[ mesh.aHalfEdgeNext[ opposite ] ];
+		}
+	}
+	// Distances from a point on sourceFace. With a target the propagation stops once no event
+	// can shorten the target distance, otherwise the whole mesh is covered.
+	void run( Mesh const &mesh , uint32_t sourceFace , float3 const &sourcePoint ,
+		uint32_t targetFace = Mesh::INVALID , float3 const &targetPoint = float3() )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		update( mesh );
+		this->sourceFace = sourceFace;
+		this->sourcePoint = sourcePoint;
+		this->targetFace = targetFace;
+		this->targetPoint = targetPoint;
+		targetDist = targetFace == sourceFace ? sourcePoint.dist( targetPoint ) : DBL_MAX;
+		stats = ExactGeodesicStats();
+		aWindows.clear();
+		aHalfEdgeWindows.assign( mesh.getHalfEdgeCount() , NONE );
+		aVertexDist.assign( mesh.getVertexCount() , DBL_MAX );
+		aVertexFromWindow.assign( mesh.getVertexCount() , NONE );
+		aVertexFromVertex.assign( mesh.getVertexCount() , NONE );
+		aSplitDist.assign( mesh.getHalfEdgeCount() , DBL_MAX );
+		aSplitX.assign( mesh.getHalfEdgeCount() , 0.0 );
+		eventQ = decltype( eventQ )();
+		uint32_t hedge = mesh.aFaceHalfEdge[ sourceFace ];
+		ito( 3 )
+		{
+			updateVertex( mesh.aHalfEdgeOrigin[ hedge ] , sourcePoint.dist( mesh.getOrigin( hedge ) ) , NONE , NONE );
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		ito( 3 )
+		{
+			Frame frame = getFrame( hedge );
+			double sx , sy;
+			toFrame( frame , sourcePoint , sx , sy );
+			addChildWindow( hedge , 0.0 , 0.0 , frame.length , 0.0 , 0.0 , 1.0 , sx , sy , 0.0 , NONE , NONE );
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		while( !eventQ.empty() )
+		{
+			Event event = eventQ.top();
+			eventQ.pop();
+			if( event.key >= targetDist )
+			{
+				break;
+			}
+			if( event.isVertex )
+			{
+				if( event.key == aVertexDist[ event.id ] )
+				{
+					emitVertex( event.id );
+				}
+			} else if( isPruned( aWindows[ event.id ] ) )
+			{
+				stats.windowsPruned++;
+			} else
+			{
+				propagate( event.id );
+			}
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Geodesic distance to a point on face, reads windows entering the face and the face's vertices
+	double getDistance( uint32_t face , float3 const &point , uint32_t *pWindow = nullptr , uint32_t *pVertex = nullptr ) const
+	{
+		Mesh const &mesh = *pMesh;
+		double best = face == sourceFace ? sourcePoint.dist( point ) : DBL_MAX;
+		uint32_t bestWindow = NONE , bestVertex = NONE;
+		uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+		ito( 3 )
+		{
+			uint32_t vertex = mesh.aHalfEdgeOrigin[ hedge ];
+			if( aVertexDist[ vertex ] != DBL_MAX && aVertexDist[ vertex ] + mesh.aPositions[ vertex ].dist( point ) < best )
+			{
+				best = aVertexDist[ vertex ] + mesh.aPositions[ vertex ].dist( point );
+				bestWindow = NONE;
+				bestVertex = vertex;
+			}
+			for( uint32_t id = aHalfEdgeWindows[ hedge ]; id != NONE; id = aWindows[ id ].nextOnEdge )
+			{
+				double dist = getWindowDistance( aWindows[ id ] , point );
+				if( dist < best )
+				{
+					best = dist;
+					bestWindow = id;
+					bestVertex = NONE;
+				}
+			}
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		if( pWindow )
+		{
+			*pWindow = bestWindow;
+		}
+		if( pVertex )
+		{
+			*pVertex = bestVertex;
+		}
+		return best;
+	}
+	double getVertexDistance( uint32_t vertex ) const
+	{
+		return aVertexDist[ vertex ];
+	}
+	void traceVertex( uint32_t vertex , std::vector< float3 > &path ) const
+	{
+		while( true )
+		{
+			path.push_back( pMesh->aPositions[ vertex ] );
+			if( aVertexFromWindow[ vertex ] != NONE )
+			{
+				traceWindow( aVertexFromWindow[ vertex ] , pMesh->aPositions[ vertex ] , path );
+				return;
+			}
+			if( aVertexFromVertex[ vertex ] == NONE )
+			{
+				path.push_back( sourcePoint );
+				return;
+			}
+			vertex = aVertexFromVertex[ vertex ];
+		}
+	}
+	// Follows the straight unfolded ray from a point in the window's face back through its ancestors
+	void traceWindow( uint32_t id , float3 point , std::vector< float3 > &path ) const
+	{
+		while( true )
+		{
+			Window const &window = aWindows[ id ];
+			Frame frame = getFrame( window.hedge );
+			double x , y;
+			toFrame( frame , point , x , y );
+			double denom = window.sy - y;
+			double cross = denom > 0.0 ? window.sx + ( x - window.sx ) * window.sy / denom : x;
+			cross = cross < window.b0 ? window.b0 : cross > window.b1 ? window.b1 : cross;
+			point = frame.origin + frame.axis * float( cross );
+			path.push_back( point );
+			if( window.parent != NONE )
+			{
+				id = window.parent;
+			} else if( window.sourceVertex != NONE )
+			{
+				traceVertex( window.sourceVertex , path );
+				return;
+			} else
+			{
+				path.push_back( sourcePoint );
+				return;
+			}
+		}
+	}
+	// Polyline from point back to the source point
+	void getPath( uint32_t face , float3 const &point , std::vector< float3 > &path ) const
+	{
+		path.clear();
+		uint32_t window , vertex;
+		if( getDistance( face , point , &window , &vertex ) == DBL_MAX )
+		{
+			return;
+		}
+		path.push_back( point );
+		if( window != NONE )
+		{
+			traceWindow( window , point , path );
+		} else if( vertex != NONE )
+		{
+			traceVertex( vertex , path );
+		} else
+		{
+			path.push_back( sourcePoint );
+		}
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <float.h>
+#include <vector>
+// Per-face distance and parent of one search, stamped with the epoch of the query that wrote them.
+// A stale stamp reads as unreached, so starting a query bumps the epoch instead of clearing every face.
+// Stamp, distance and parent share one record, a relaxation touches a single cache line.
+struct FaceLabels
+{
+	struct Label
+	{
+		uint32_t stamp;
+		float dist;
+		uint32_t from;
+	};
+	std::vector< Label > aLabels;
+	uint32_t epoch = 0;
+	// Starts a new query, only clears the labels when the face count changes or the epoch wraps
+	void begin( uint32_t faceCount )
+	{
+		if( aLabels.size() != faceCount || ++epoch == 0 )
+		{
+			aLabels.assign( faceCount , { 0 , FLT_MAX , Mesh::INVALID } );
+			epoch = 1;
+		}
+	}
+	bool isReached( uint32_t face ) const
+	{
+		return aLabels[ face ].stamp == epoch;
+	}
+	float getDist( uint32_t face ) const
+	{
+		Label const &label = aLabels[ face ];
+		return label.stamp == epoch ? label.dist : FLT_MAX;
+	}
+	uint32_t getFrom( uint32_t face ) const
+	{
+		Label const &label = aLabels[ face ];
+		return label.stamp == epoch ? label.from : Mesh::INVALID;
+	}
+	void set( uint32_t face , float dist , uint32_t from )
+	{
+		aLabels[ face ] = { epoch , dist , from };
+	}
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "geodesic/DualGraph.hpp"
+#include "geodesic/IndexedHeap.hpp"
+#include "geodesic/FaceLabels.hpp"
+#include "geodesic/Landmarks.hpp"
+#include <algorithm>
+struct FaceSearchStats
+{
+	uint32_t settled = 0;
+	uint32_t pushed = 0;
+	uint32_t decreased = 0;
+};
+// Picked faces and points of a point-to-point query. Inside the two picked faces the path runs
+// through the picked points instead of the centroids, which keeps arc weights symmetric.
+struct SearchEndpoints
+{
+	uint32_t sourceFace = Mesh::INVALID;
+	uint32_t targetFace = Mesh::INVALID;
+	float3 sourcePoint;
+	float3 targetPoint;
+	float3 getAnchor( DualGraph const &graph , uint32_t face ) const
+	{
+		return face == sourceFace ? sourcePoint : face == targetFace ? targetPoint : graph.aFaceCenter[ face ];
+	}
+	float getArcWeight( DualGraph const &graph , uint32_t face , uint32_t arc ) const
+	{
+		uint32_t adjFace = graph.aArcFace[ arc ];
+		if( face != sourceFace && face != targetFace && adjFace != sourceFace && adjFace != targetFace )
+		{
+			return graph.aArcWeight[ arc ];
+		}
+		return graph.getArcWeight( arc , getAnchor( graph , face ) , getAnchor( graph , adjFace ) );
+	}
+};
+// Dijkstra over the dual graph, every face is settled at most once.
+// Without fullFlood the search is A* guided by the straight-line distance to the target point and
+// stops once the target face is settled. Every arc is at least as long as the segment between
+// the two centroids, so the heuristic is consistent and the target distance stays exact.
+// With landmarks the heuristic is also at least the ALT bound to the target centroid. Arcs into the
+// target face run to the target point instead, which shortens them by at most the distance from the
+// point to the centroid, so the bound drops by that much to stay consistent.
+struct FaceSearch
+{
+	IndexedHeap< 4 > heap;
+	FaceLabels labels;
+	FaceSearchStats stats;
+	SearchEndpoints endpoints;
+	// Costs O( faces touched by the previous query ), the labels are invalidated by their epoch
+	void reset( uint32_t faceCount )
+	{
+		if( labels.aLabels.size() != faceCount )
+		{
+			heap.init( faceCount );
+		} else
+		{
+			heap.clear();
+		}
+		labels.begin( faceCount );
+		stats = FaceSearchStats();
+	}
+	// pLandmarks must be valid for graph, it is ignored by a full flood
+	void run( DualGraph const &graph , SearchEndpoints const &endpoints , bool fullFlood = true , Landmarks const *pLandmarks = nullptr )
+	{
+		this->endpoints = endpoints;
+		uint32_t sourceFace = endpoints.sourceFace;
+		uint32_t targetFace = endpoints.targetFace;
+		float3 const &targetPoint = endpoints.targetPoint;
+		float targetSlack = pLandmarks && !fullFlood ? targetPoint.dist( graph.aFaceCenter[ targetFace ] ) : 0.0f;
+		reset( graph.getFaceCount() );
+		labels.set( sourceFace , 0.0f , Mesh::INVALID );
+		heap.push( sourceFace , 0.0f );
+		stats.pushed++;
+		while( !heap.empty() )
+		{
+			uint32_t face = heap.pop();
+			stats.settled++;
+			if( !fullFlood && face == targetFace )
+			{
+				break;
+			}
+			float faceDist = labels.getDist( face );
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjFace = graph.aArcFace[ arc ];
+				float dist = faceDist + endpoints.getArcWeight( graph , face , arc );
+				if( dist < labels.getDist( adjFace ) )
+				{
+					labels.set( adjFace , dist , face );
+					float key = dist;
+					if( !fullFlood )
+					{
+						float heuristic = graph.aFaceCenter[ adjFace ].dist( targetPoint );
+						if( pLandmarks )
+						{
+							heuristic = std::max( heuristic , pLandmarks->getLowerBound( adjFace , targetFace ) - targetSlack );
+						}
+						key += heuristic;
+					}
+					if( heap.pushOrDecrease( adjFace , key ) )
+					{
+						stats.pushed++;
+					} else
+					{
+						stats.decreased++;
+					}
+				}
+			}
+		}
+	}
+	// FLT_MAX for faces the search did not reach
+	float getDistance( uint32_t face ) const
+	{
+		return labels.getDist( face );
+	}
+	// Faces from the target back to the source, empty if the target was not reached
+	void getCorridor( std::vector< uint32_t > &aCorridor ) const
+	{
+		aCorridor.clear();
+		uint32_t face = endpoints.targetFace;
+		while( face != Mesh::INVALID )
+		{
+			aCorridor.push_back( face );
+			if( face == endpoints.sourceFace )
+			{
+				return;
+			}
+			face = labels.getFrom( face );
+		}
+		aCorridor.clear();
+	}
+};
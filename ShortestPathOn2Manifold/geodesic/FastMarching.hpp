@@ -0,0 +1,417 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include "geodesic/IndexedHeap.hpp"
+#include <float.h>
+#include <math.h>
+#include <chrono>
+struct FastMarchingStats
+{
+	uint32_t accepted = 0;
+	uint32_t updated = 0;
+	uint32_t splitUpdates = 0;
+	double seconds = 0.0;
+};
+// First-order Fast Marching on mesh vertices. Trial vertices wait in a heap-ordered narrow band, a
+// triangle update takes the best linear interpolation of two accepted values along the opposite edge.
+// Obtuse corners are split by a vertex unfolded from the neighbouring faces so that both virtual
+// triangles are acute, which keeps every update causal.
+struct FastMarching
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	enum State : uint8_t
+	{
+		FAR ,
+		TRIAL ,
+		ALIVE
+	};
+	// Unfolded vertex splitting the obtuse corner opposite a half-edge, in the corner's frame:
+	// corner vertex at the origin, half-edge origin along +x, half-edge end at y > 0
+	struct Split
+	{
+		uint32_t vertex;
+		float x , y;
+	};
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	uint32_t maxUnfoldSteps = 16;
+	std::vector< uint32_t > aVertexOffsets;
+	std::vector< uint32_t > aVertexHalfEdges;
+	std::vector< Split > aSplits;
+	IndexedHeap< 4 > heap;
+	std::vector< double > aDist;
+	std::vector< State > aState;
+	uint32_t sourceFace = Mesh::INVALID;
+	float3 sourcePoint;
+	FastMarchingStats stats;
+	void update( Mesh const &mesh )
+	{
+		if( pMesh != &mesh || meshVersion != mesh.version )
+		{
+			build( mesh );
+		}
+	}
+	// Corner frame coordinates of the half-edge's endpoints as seen from the opposite vertex
+	void getCornerFrame( uint32_t hedge , float &ax , float &bx , float &by ) const
+	{
+		Mesh const &mesh = *pMesh;
+		float3 const &corner = mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] );
+		float3 a = mesh.getOrigin( hedge ) - corner;
+		float3 b = mesh.aPositions[ mesh.getEnd( hedge ) ] - corner;
+		ax = a.mod();
+		bx = a * b / ax;
+		by = sqrtf( fmaxf( b * b - bx * bx , 0.0f ) );
+	}
+	// Walks the strip of faces across the half-edge until a vertex lands inside the acute sector of the corner
+	Split findSplit( uint32_t hedge ) const
+	{
+		Mesh const &mesh = *pMesh;
+		Split split = { NONE , 0.0f , 0.0f };
+		float ax , bx , by;
+		getCornerFrame( hedge , ax , bx , by );
+		// Unfolded edge P -> Q being crossed, in the corner frame
+		float px = ax , py = 0.0f , qx = bx , qy = by;
+		// Acute sector: directions with positive dot product against both corner edges
+		float3 sideA = float3( 1.0f , 0.0f , 0.0f ) , sideB = float3( bx , by , 0.0f );
+		uint32_t crossed = hedge;
+		for( uint32_t step = 0; step < maxUnfoldSteps; step++ )
+		{
+			uint32_t twin = mesh.aHalfEdgeTwin[ crossed ];
+			if( twin == Mesh::INVALID )
+			{
+				return split;
+			}
+			// Third vertex of the twin's face, placed on the far side of P -> Q
+			uint32_t third = mesh.aHalfEdgeOrigin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ twin ] ] ];
+			float3 origin = mesh.getOrigin( twin );
+			float3 axis = mesh.aPositions[ mesh.getEnd( twin ) ] - origin;
+			float3 rel = mesh.aPositions[ third ] - origin;
+			float along = rel * axis / ( axis * axis );
+			float across = sqrtf( fmaxf( rel * rel - along * along * ( axis * axis ) , 0.0f ) ) / axis.mod();
+			// twin runs Q -> P in the unfolded plane, the far side is to the right of P -> Q
+			float ex = px - qx , ey = py - qy;
+			float dx = qx + ex * along - ey * across;
+			float dy = qy + ey * along + ex * across;
+			float3 d = float3( dx , dy , 0.0f );
+			if( d * sideA > 0.0f && d * sideB > 0.0f )
+			{
+				split = { third , dx , dy };
+				return split;
+			}
+			// Continue across the edge the sector's bisector passes through
+			float3 bisector = float3( 1.0f , 0.0f , 0.0f ) * ( 1.0f / ax ) + float3( bx , by , 0.0f ) * ( 1.0f / sqrtf( bx * bx + by * by ) );
+			float side = bisector.x * dy - bisector.y * dx;
+			uint32_t next = mesh.aHalfEdgeNext[ twin ];
+			if( side > 0.0f )
+			{
+				// Bisector passes between P and D, the twin's next half-edge runs P -> D
+				crossed = next;
+				qx = dx;
+				qy = dy;
+			} else
+			{
+				crossed = mesh.aHalfEdgeNext[ next ];
+				px = dx;
+				py = dy;
+			}
+		}
+		return split;
+	}
+	void build( Mesh const &mesh )
+	{
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		uint32_t vertexCount = mesh.getVertexCount();
+		uint32_t hedgeCount = mesh.getHalfEdgeCount();
+		aVertexOffsets.assign( vertexCount + 1 , 0 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexOffsets[ mesh.aHalfEdgeOrigin[ hedge ] + 1 ]++;
+		}
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aVertexOffsets[ vertex + 1 ] += aVertexOffsets[ vertex ];
+		}
+		aVertexHalfEdges.resize( hedgeCount );
+		std::vector< uint32_t > aFill( aVertexOffsets.begin() , aVertexOffsets.end() - 1 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexHalfEdges[ aFill[ mesh.aHalfEdgeOrigin[ hedge ] ]++ ] = hedge;
+		}
+		aSplits.resize( hedgeCount );
+#pragma omp parallel for
+		for( int hedge = 0; hedge < int( hedgeCount ); hedge++ )
+		{
+			float ax , bx , by;
+			getCornerFrame( hedge , ax , bx , by );
+			aSplits[ hedge ] = bx < 0.0f ? findSplit( hedge ) : Split{ NONE , 0.0f , 0.0f };
+		}
+	}
+	// Best arrival at the origin over the segment a -> b carrying linearly interpolated distances
+	static double solveTriangle( double ax , double ay , double da , double bx , double by , double db )
+	{
+		double ex = bx - ax , ey = by - ay;
+		double length2 = ex * ex + ey * ey;
+		double best = fmin( da + sqrt( ax * ax + ay * ay ) , db + sqrt( bx * bx + by * by ) );
+		double u = db - da;
+		if( length2 <= 0.0 || u * u >= length2 )
+		{
+			return best;
+		}
+		// Foot of the origin on the line and the offset where the slope of the distance matches u
+		double foot = -( ax * ex + ay * ey ) / length2;
+		double hx = ax + ex * foot , hy = ay + ey * foot;
+		double height = sqrt( hx * hx + hy * hy );
+		double lambda = foot - u * height / sqrt( length2 * ( length2 - u * u ) );
+		if( lambda > 0.0 && lambda < 1.0 )
+		{
+			double wx = ax + ex * lambda , wy = ay + ey * lambda;
+			best = fmin( best , da + u * lambda + sqrt( wx * wx + wy * wy ) );
+		}
+		return best;
+	}
+	// Updates the corner opposite hedge from its two endpoints
+	void updateCorner( uint32_t hedge )
+	{
+		Mesh const &mesh = *pMesh;
+		uint32_t vertex = mesh.aHalfEdgeOrigin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ];
+		if( aState[ vertex ] == ALIVE )
+		{
+			return;
+		}
+		uint32_t a = mesh.aHalfEdgeOrigin[ hedge ] , b = mesh.getEnd( hedge );
+		float ax , bx , by;
+		getCornerFrame( hedge , ax , bx , by );
+		double best = aDist[ vertex ];
+		if( aState[ a ] == ALIVE )
+		{
+			best = fmin( best , aDist[ a ] + ax );
+		}
+		if( aState[ b ] == ALIVE )
+		{
+			best = fmin( best , aDist[ b ] + sqrt( double( bx ) * bx + double( by ) * by ) );
+		}
+		if( aState[ a ] == ALIVE && aState[ b ] == ALIVE )
+		{
+			Split const &split = aSplits[ hedge ];
+			if( bx >= 0.0f )
+			{
+				best = fmin( best , solveTriangle( ax , 0.0 , aDist[ a ] , bx , by , aDist[ b ] ) );
+			} else if( split.vertex != NONE && aState[ split.vertex ] == ALIVE )
+			{
+				double dSplit = aDist[ split.vertex ];
+				best = fmin( best , solveTriangle( ax , 0.0 , aDist[ a ] , split.x , split.y , dSplit ) );
+				best = fmin( best , solveTriangle( split.x , split.y , dSplit , bx , by , aDist[ b ] ) );
+				stats.splitUpdates++;
+			}
+		}
+		if( best < aDist[ vertex ] )
+		{
+			aDist[ vertex ] = best;
+			stats.updated++;
+			if( heap.pushOrDecrease( vertex , float( best ) ) )
+			{
+				aState[ vertex ] = TRIAL;
+			}
+		}
+	}
+	// Distances from a point on sourceFace. With a target face the march stops once its vertices are accepted.
+	void run( Mesh const &mesh , uint32_t sourceFace , float3 const &sourcePoint , uint32_t targetFace = Mesh::INVALID )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		update( mesh );
+		this->sourceFace = sourceFace;
+		this->sourcePoint = sourcePoint;
+		stats = FastMarchingStats();
+		uint32_t vertexCount = mesh.getVertexCount();
+		if( heap.aPosition.size() != vertexCount )
+		{
+			heap.init( vertexCount );
+		} else
+		{
+			heap.clear();
+		}
+		aDist.assign( vertexCount , DBL_MAX );
+		aState.assign( vertexCount , FAR );
+		uint32_t hedge = mesh.aFaceHalfEdge[ sourceFace ];
+		ito( 3 )
+		{
+			uint32_t vertex = mesh.aHalfEdgeOrigin[ hedge ];
+			aDist[ vertex ] = sourcePoint.dist( mesh.aPositions[ vertex ] );
+			aState[ vertex ] = TRIAL;
+			heap.push( vertex , float( aDist[ vertex ] ) );
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		uint32_t targetRemaining = targetFace == Mesh::INVALID ? uint32_t( NONE ) : 3u;
+		while( !heap.empty() && targetRemaining != 0 )
+		{
+			uint32_t vertex = heap.pop();
+			aState[ vertex ] = ALIVE;
+			stats.accepted++;
+			for( uint32_t i = aVertexOffsets[ vertex ]; i < aVertexOffsets[ vertex + 1 ]; i++ )
+			{
+				uint32_t out = aVertexHalfEdges[ i ];
+				uint32_t next = mesh.aHalfEdgeNext[ out ];
+				// Corners opposite out and opposite the half-edge coming back into the vertex
+				updateCorner( out );
+				updateCorner( mesh.aHalfEdgeNext[ next ] );
+				if( mesh.aHalfEdgeFace[ out ] == targetFace )
+				{
+					targetRemaining--;
+				}
+			}
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	double getVertexDistance( uint32_t vertex ) const
+	{
+		return aDist[ vertex ];
+	}
+	// Distance gradient of the linear interpolant over face
+	float3 getGradient( uint32_t face ) const
+	{
+		Mesh const &mesh = *pMesh;
+		uint32_t h0 = mesh.aFaceHalfEdge[ face ];
+		uint32_t h1 = mesh.aHalfEdgeNext[ h0 ];
+		uint32_t h2 = mesh.aHalfEdgeNext[ h1 ];
+		float3 const &p0 = mesh.getOrigin( h0 );
+		float3 const &p1 = mesh.getOrigin( h1 );
+		float3 const &p2 = mesh.getOrigin( h2 );
+		float3 normal = ( p1 - p0 ) ^ ( p2 - p0 );
+		float area2 = normal * normal;
+		if( area2 <= 0.0f )
+		{
+			return float3( 0.0f );
+		}
+		double d0 = aDist[ mesh.aHalfEdgeOrigin[ h0 ] ];
+		double d1 = aDist[ mesh.aHalfEdgeOrigin[ h1 ] ];
+		double d2 = aDist[ mesh.aHalfEdgeOrigin[ h2 ] ];
+		// Relative to the face's first vertex so large distances keep their precision
+		return ( ( normal ^ ( p0 - p2 ) ) * float( d1 - d0 ) + ( normal ^ ( p1 - p0 ) ) * float( d2 - d0 ) ) / area2;
+	}
+	// Polyline from point back to the source point descending the distance gradient face by face.
+	// Where the descent runs into an edge it follows the edge to its lower vertex and continues from there.
+	void getPath( uint32_t face , float3 const &point , std::vector< float3 > &path ) const
+	{
+		Mesh const &mesh = *pMesh;
+		path.clear();
+		path.push_back( point );
+		uint32_t vertex = NONE;
+		uint32_t maxSteps = mesh.getFaceCount() * 4 + 16;
+		for( uint32_t step = 0; step < maxSteps; step++ )
+		{
+			if( face == sourceFace )
+			{
+				path.push_back( sourcePoint );
+				return;
+			}
+			if( vertex != NONE )
+			{
+				// Pick the incident face whose descent direction leaves the vertex through its interior
+				uint32_t bestHedge = NONE , lowest = vertex;
+				float3 const &pos = mesh.aPositions[ vertex ];
+				for( uint32_t i = aVertexOffsets[ vertex ]; i < aVertexOffsets[ vertex + 1 ]; i++ )
+				{
+					uint32_t out = aVertexHalfEdges[ i ];
+					if( mesh.aHalfEdgeFace[ out ] == sourceFace )
+					{
+						path.push_back( sourcePoint );
+						return;
+					}
+					// Both other corners, so boundary neighbours only reached by an incoming half-edge count too
+					uint32_t end = mesh.getEnd( out );
+					uint32_t third = mesh.aHalfEdgeOrigin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ out ] ] ];
+					lowest = aDist[ end ] < aDist[ lowest ] ? end : lowest;
+					lowest = aDist[ third ] < aDist[ lowest ] ? third : lowest;
+					float3 descent = -getGradient( mesh.aHalfEdgeFace[ out ] );
+					float3 e0 = mesh.aPositions[ end ] - pos;
+					float3 e1 = mesh.aPositions[ third ] - pos;
+					float3 normal = e0 ^ e1;
+					if( descent * descent > 0.0f && ( e0 ^ descent ) * normal > 0.0f && ( descent ^ e1 ) * normal > 0.0f )
+					{
+						bestHedge = out;
+					}
+				}
+				if( bestHedge != NONE )
+				{
+					face = mesh.aHalfEdgeFace[ bestHedge ];
+					vertex = NONE;
+					// Cross the face from the vertex straight to its opposite edge
+					uint32_t opposite = mesh.aHalfEdgeNext[ bestHedge ];
+					float3 descent = -getGradient( face );
+					float3 q0 = mesh.getOrigin( opposite ) , q1 = mesh.aPositions[ mesh.getEnd( opposite ) ];
+					float3 normal = ( q0 - pos ) ^ ( q1 - pos );
+					float denom = ( descent ^ ( q1 - q0 ) ) * normal;
+					float s = denom != 0.0f ? ( ( q0 - pos ) ^ ( q1 - q0 ) ) * normal / denom : 0.0f;
+					float3 exit = pos + descent * s;
+					path.push_back( exit );
+					uint32_t adjFace = mesh.getAdjacentFace( opposite );
+					if( adjFace == Mesh::INVALID )
+					{
+						return;
+					}
+					face = adjFace;
+					continue;
+				}
+				if( lowest == vertex )
+				{
+					return;
+				}
+				vertex = lowest;
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			// Inside a face: march along the descent direction to the first edge it hits
+			float3 start = path.back();
+			float3 descent = -getGradient( face );
+			uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+			uint32_t exitHedge = NONE;
+			float exitS = FLT_MAX;
+			ito( 3 )
+			{
+				float3 q0 = mesh.getOrigin( hedge ) , q1 = mesh.aPositions[ mesh.getEnd( hedge ) ];
+				float3 normal = ( q1 - q0 ) ^ ( mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ) - q0 );
+				float denom = ( descent ^ ( q1 - q0 ) ) * normal;
+				if( denom > 0.0f )
+				{
+					float s = ( ( q0 - start ) ^ ( q1 - q0 ) ) * normal / denom;
+					if( s < exitS )
+					{
+						exitS = s;
+						exitHedge = hedge;
+					}
+				}
+				hedge = mesh.aHalfEdgeNext[ hedge ];
+			}
+			uint32_t adjFace = exitHedge == NONE ? Mesh::INVALID : mesh.getAdjacentFace( exitHedge );
+			if( adjFace == Mesh::INVALID || exitS <= 0.0f || descent * descent == 0.0f )
+			{
+				// Stuck on an edge or against the boundary, fall back to the face's lowest vertex
+				uint32_t lowest = NONE;
+				hedge = mesh.aFaceHalfEdge[ face ];
+				ito( 3 )
+				{
+					uint32_t candidate = mesh.aHalfEdgeOrigin[ hedge ];
+					lowest = lowest == NONE || aDist[ candidate ] < aDist[ lowest ] ? candidate : lowest;
+					hedge = mesh.aHalfEdgeNext[ hedge ];
+				}
+				vertex = lowest;
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			float3 exit = start + descent * exitS;
+			path.push_back( exit );
+			// Descent in the next face pointing straight back means a valley along the edge
+			float3 nextDescent = -getGradient( adjFace );
+			uint32_t twin = mesh.aHalfEdgeTwin[ exitHedge ];
+			float3 q0 = mesh.getOrigin( twin ) , q1 = mesh.aPositions[ mesh.getEnd( twin ) ];
+			float3 adjNormal = ( q1 - q0 ) ^ ( mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ twin ] ] ) - q0 );
+			if( ( nextDescent ^ ( q1 - q0 ) ) * adjNormal >= 0.0f )
+			{
+				vertex = aDist[ mesh.aHalfEdgeOrigin[ twin ] ] < aDist[ mesh.getEnd( twin ) ] ? mesh.aHalfEdgeOrigin[ twin ] : mesh.getEnd( twin );
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			face = adjFace;
+		}
+	}
+};
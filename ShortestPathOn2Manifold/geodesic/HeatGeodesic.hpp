@@ -0,0 +1,407 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include "geodesic/SparseLDLT.hpp"
+#include <float.h>
+#include <math.h>
+struct HeatGeodesicStats
+{
+	double buildSeconds = 0.0;
+	double solveSeconds = 0.0;
+	uint32_t heatNonZeros = 0;
+	uint32_t poissonNonZeros = 0;
+};
+// Geodesic distance field by the heat method (Crane et al.): diffuse heat from the source for a short time,
+// normalize its gradient per face and integrate it back with a Poisson solve. Both systems only depend on
+// the mesh, so ( M + tL ) and L are factored once per mesh version and each source costs two solves.
+// L is the positive semi-definite cotan Laplacian and M the lumped mass matrix.
+struct HeatGeodesic
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	// Time step is timeFactor * ( mean edge length )^2
+	double timeFactor = 1.0;
+	double timeStep = 0.0;
+	bool factored = false;
+	// Cotangent of the angle opposite each half-edge
+	std::vector< double > aCotan;
+	std::vector< double > aMass;
+	std::vector< uint32_t > aVertexOffsets;
+	std::vector< uint32_t > aVertexHalfEdges;
+	// One vertex per connected component, fixes the constant the Poisson equation leaves free
+	std::vector< uint8_t > aPinned;
+	SparseLDLT heatSolver;
+	SparseLDLT poissonSolver;
+	std::vector< double > aHeat;
+	std::vector< double > aDivergence;
+	std::vector< double > aDist;
+	uint32_t sourceFace = Mesh::INVALID;
+	float3 sourcePoint;
+	HeatGeodesicStats stats;
+	static double cotan( float3 const &a , float3 const &b )
+	{
+		return double( a * b ) / double( ( a ^ b ).mod() );
+	}
+	void update( Mesh const &mesh )
+	{
+		if( pMesh != &mesh || meshVersion != mesh.version )
+		{
+			build( mesh );
+		}
+	}
+	void build( Mesh const &mesh )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		uint32_t vertexCount = mesh.getVertexCount();
+		uint32_t hedgeCount = mesh.getHalfEdgeCount();
+		aCotan.resize( hedgeCount );
+		aMass.assign( vertexCount , 0.0 );
+		double edgeSum = 0.0;
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			uint32_t prev = mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ];
+			float3 const &opposite = mesh.getOrigin( prev );
+			aCotan[ hedge ] = cotan( mesh.getOrigin( hedge ) - opposite , mesh.aPositions[ mesh.getEnd( hedge ) ] - opposite );
+			edgeSum += mesh.getEdgeLength( hedge );
+		}
+		for( uint32_t face = 0; face < mesh.getFaceCount(); face++ )
+		{
+			double area = mesh.getFaceArea( face );
+			uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+			ito( 3 )
+			{
+				aMass[ mesh.aHalfEdgeOrigin[ hedge ] ] += area / 3.0;
+				hedge = mesh.aHalfEdgeNext[ hedge ];
+			}
+		}
+		aVertexOffsets.assign( vertexCount + 1 , 0 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexOffsets[ mesh.aHalfEdgeOrigin[ hedge ] + 1 ]++;
+		}
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aVertexOffsets[ vertex + 1 ] += aVertexOffsets[ vertex ];
+		}
+		aVertexHalfEdges.resize( hedgeCount );
+		std::vector< uint32_t > aFill( aVertexOffsets.begin() , aVertexOffsets.end() - 1 );
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aVertexHalfEdges[ aFill[ mesh.aHalfEdgeOrigin[ hedge ] ]++ ] = hedge;
+		}
+		double meanEdge = hedgeCount ? edgeSum / hedgeCount : 0.0;
+		timeStep = timeFactor * meanEdge * meanEdge;
+		// Components by union-find over the edges
+		std::vector< uint32_t > aRoot( vertexCount );
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aRoot[ vertex ] = vertex;
+		}
+		auto find = [ & ]( uint32_t vertex )
+		{
+			while( aRoot[ vertex ] != vertex )
+			{
+				aRoot[ vertex ] = aRoot[ aRoot[ vertex ] ];
+				vertex = aRoot[ vertex ];
+			}
+			return vertex;
+		};
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			aRoot[ find( mesh.aHalfEdgeOrigin[ hedge ] ) ] = find( mesh.getEnd( hedge ) );
+		}
+		aPinned.assign( vertexCount , 0 );
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aPinned[ find( vertex ) ] = 1;
+		}
+		// Pinned rows and columns of L are replaced by the identity, unreferenced vertices get a unit diagonal
+		std::vector< SparseMatrix::Triplet > aHeatTriplets , aPoissonTriplets;
+		aHeatTriplets.reserve( hedgeCount * 4 + vertexCount );
+		aPoissonTriplets.reserve( hedgeCount * 4 + vertexCount );
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aHeatTriplets.push_back( { vertex , vertex , aMass[ vertex ] > 0.0 ? aMass[ vertex ] : 1.0 } );
+			if( aPinned[ vertex ] )
+			{
+				aPoissonTriplets.push_back( { vertex , vertex , 1.0 } );
+			}
+		}
+		for( uint32_t hedge = 0; hedge < hedgeCount; hedge++ )
+		{
+			uint32_t a = mesh.aHalfEdgeOrigin[ hedge ];
+			uint32_t b = mesh.getEnd( hedge );
+			double weight = aCotan[ hedge ] * 0.5;
+			aHeatTriplets.push_back( { a , b , -timeStep * weight } );
+			aHeatTriplets.push_back( { b , a , -timeStep * weight } );
+			aHeatTriplets.push_back( { a , a , timeStep * weight } );
+			aHeatTriplets.push_back( { b , b , timeStep * weight } );
+			if( !aPinned[ a ] && !aPinned[ b ] )
+			{
+				aPoissonTriplets.push_back( { a , b , -weight } );
+				aPoissonTriplets.push_back( { b , a , -weight } );
+			}
+			if( !aPinned[ a ] )
+			{
+				aPoissonTriplets.push_back( { a , a , weight } );
+			}
+			if( !aPinned[ b ] )
+			{
+				aPoissonTriplets.push_back( { b , b , weight } );
+			}
+		}
+		SparseMatrix heatMatrix , poissonMatrix;
+		heatMatrix.build( vertexCount , aHeatTriplets );
+		poissonMatrix.build( vertexCount , aPoissonTriplets );
+		factored = heatSolver.factor( heatMatrix ) && poissonSolver.factor( poissonMatrix );
+		stats.heatNonZeros = heatSolver.stats.factorNonZeros;
+		stats.poissonNonZeros = poissonSolver.stats.factorNonZeros;
+		stats.buildSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Distance field from a point on face, false if the mesh could not be factored
+	bool run( Mesh const &mesh , uint32_t face , float3 const &point )
+	{
+		update( mesh );
+		if( !factored )
+		{
+			return false;
+		}
+		sourceFace = face;
+		sourcePoint = point;
+		auto start = std::chrono::high_resolution_clock::now();
+		uint32_t vertexCount = mesh.getVertexCount();
+		float aWeights[ 3 ];
+		mesh.getBarycentric( sourceFace , sourcePoint , aWeights );
+		aHeat.assign( vertexCount , 0.0 );
+		uint32_t hedge = mesh.aFaceHalfEdge[ sourceFace ];
+		ito( 3 )
+		{
+			aHeat[ mesh.aHalfEdgeOrigin[ hedge ] ] += aWeights[ i ];
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		heatSolver.solve( aHeat );
+		// Unit field against the heat gradient, rescaled per face first so decayed heat keeps its direction
+		int faceCount = int( mesh.getFaceCount() );
+		std::vector< float3 > aField( faceCount );
+#pragma omp parallel for
+		for( int face = 0; face < faceCount; face++ )
+		{
+			uint32_t h0 = mesh.aFaceHalfEdge[ face ];
+			uint32_t h1 = mesh.aHalfEdgeNext[ h0 ];
+			uint32_t h2 = mesh.aHalfEdgeNext[ h1 ];
+			double u0 = aHeat[ mesh.aHalfEdgeOrigin[ h0 ] ];
+			double u1 = aHeat[ mesh.aHalfEdgeOrigin[ h1 ] ];
+			double u2 = aHeat[ mesh.aHalfEdgeOrigin[ h2 ] ];
+			double scale = fmax( fabs( u0 ) , fmax( fabs( u1 ) , fabs( u2 ) ) );
+			if( scale == 0.0 )
+			{
+				aField[ face ] = float3( 0.0f );
+				continue;
+			}
+			FaceRecord const &record = mesh.aFaceRecords[ face ];
+			// Each vertex weighs the edge opposite to it, rotated in the face plane
+			float3 gradient = ( record.normal ^ ( record.p2 - record.p1 ) ) * float( u0 / scale )
+				+ ( record.normal ^ ( record.p0 - record.p2 ) ) * float( u1 / scale )
+				+ ( record.normal ^ record.e1 ) * float( u2 / scale );
+			float length = gradient.mod();
+			aField[ face ] = length > 0.0f ? gradient * ( -1.0f / length ) : float3( 0.0f );
+		}
+		aDivergence.assign( vertexCount , 0.0 );
+		for( uint32_t hedge = 0; hedge < mesh.getHalfEdgeCount(); hedge++ )
+		{
+			uint32_t a = mesh.aHalfEdgeOrigin[ hedge ];
+			uint32_t b = mesh.getEnd( hedge );
+			double flux = 0.5 * aCotan[ hedge ] * double( ( mesh.aPositions[ b ] - mesh.aPositions[ a ] ) * aField[ mesh.aHalfEdgeFace[ hedge ] ] );
+			aDivergence[ a ] += flux;
+			aDivergence[ b ] -= flux;
+		}
+		aDist.resize( vertexCount );
+		for( uint32_t vertex = 0; vertex < vertexCount; vertex++ )
+		{
+			aDist[ vertex ] = aPinned[ vertex ] ? 0.0 : -aDivergence[ vertex ];
+		}
+		poissonSolver.solve( aDist );
+		double offset = 0.0;
+		hedge = mesh.aFaceHalfEdge[ sourceFace ];
+		ito( 3 )
+		{
+			offset += aWeights[ i ] * aDist[ mesh.aHalfEdgeOrigin[ hedge ] ];
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		for( auto &dist : aDist )
+		{
+			dist -= offset;
+		}
+		stats.solveSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		return true;
+	}
+	double getVertexDistance( uint32_t vertex ) const
+	{
+		return aDist[ vertex ];
+	}
+	// Linear interpolation of the vertex distances
+	double getDistance( uint32_t face , float3 const &point ) const
+	{
+		Mesh const &mesh = *pMesh;
+		float aWeights[ 3 ];
+		mesh.getBarycentric( face , point , aWeights );
+		double dist = 0.0;
+		uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+		ito( 3 )
+		{
+			dist += aWeights[ i ] * aDist[ mesh.aHalfEdgeOrigin[ hedge ] ];
+			hedge = mesh.aHalfEdgeNext[ hedge ];
+		}
+		return dist;
+	}
+	// Distance gradient of the linear interpolant over face
+	float3 getGradient( uint32_t face ) const
+	{
+		Mesh const &mesh = *pMesh;
+		uint32_t h0 = mesh.aFaceHalfEdge[ face ];
+		uint32_t h1 = mesh.aHalfEdgeNext[ h0 ];
+		uint32_t h2 = mesh.aHalfEdgeNext[ h1 ];
+		float3 const &p0 = mesh.getOrigin( h0 );
+		float3 const &p1 = mesh.getOrigin( h1 );
+		float3 const &p2 = mesh.getOrigin( h2 );
+		float3 normal = ( p1 - p0 ) ^ ( p2 - p0 );
+		float area2 = normal * normal;
+		if( area2 <= 0.0f )
+		{
+			return float3( 0.0f );
+		}
+		double d0 = aDist[ mesh.aHalfEdgeOrigin[ h0 ] ];
+		double d1 = aDist[ mesh.aHalfEdgeOrigin[ h1 ] ];
+		double d2 = aDist[ mesh.aHalfEdgeOrigin[ h2 ] ];
+		// Relative to the face's first vertex so large distances keep their precision
+		return ( ( normal ^ ( p0 - p2 ) ) * float( d1 - d0 ) + ( normal ^ ( p1 - p0 ) ) * float( d2 - d0 ) ) / area2;
+	}
+	// Polyline from point back to the source point descending the distance gradient face by face.
+	// Where the descent runs into an edge it follows the edge to its lower vertex and continues from there.
+	void getPath( uint32_t face , float3 const &point , std::vector< float3 > &path ) const
+	{
+		Mesh const &mesh = *pMesh;
+		path.clear();
+		path.push_back( point );
+		uint32_t vertex = NONE;
+		uint32_t maxSteps = mesh.getFaceCount() * 4 + 16;
+		for( uint32_t step = 0; step < maxSteps; step++ )
+		{
+			if( face == sourceFace )
+			{
+				path.push_back( sourcePoint );
+				return;
+			}
+			if( vertex != NONE )
+			{
+				// Pick the incident face whose descent direction leaves the vertex through its interior
+				uint32_t bestHedge = NONE , lowest = vertex;
+				float3 const &pos = mesh.aPositions[ vertex ];
+				for( uint32_t i = aVertexOffsets[ vertex ]; i < aVertexOffsets[ vertex + 1 ]; i++ )
+				{
+					uint32_t out = aVertexHalfEdges[ i ];
+					if( mesh.aHalfEdgeFace[ out ] == sourceFace )
+					{
+						path.push_back( sourcePoint );
+						return;
+					}
+					// Both other corners, so boundary neighbours only reached by an incoming half-edge count too
+					uint32_t end = mesh.getEnd( out );
+					uint32_t third = mesh.aHalfEdgeOrigin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ out ] ] ];
+					lowest = aDist[ end ] < aDist[ lowest ] ? end : lowest;
+					lowest = aDist[ third ] < aDist[ lowest ] ? third : lowest;
+					float3 descent = -getGradient( mesh.aHalfEdgeFace[ out ] );
+					float3 e0 = mesh.aPositions[ end ] - pos;
+					float3 e1 = mesh.aPositions[ third ] - pos;
+					float3 normal = e0 ^ e1;
+					if( descent * descent > 0.0f && ( e0 ^ descent ) * normal > 0.0f && ( descent ^ e1 ) * normal > 0.0f )
+					{
+						bestHedge = out;
+					}
+				}
+				if( bestHedge != NONE )
+				{
+					face = mesh.aHalfEdgeFace[ bestHedge ];
+					vertex = NONE;
+					// Cross the face from the vertex straight to its opposite edge
+					uint32_t opposite = mesh.aHalfEdgeNext[ bestHedge ];
+					float3 descent = -getGradient( face );
+					float3 q0 = mesh.getOrigin( opposite ) , q1 = mesh.aPositions[ mesh.getEnd( opposite ) ];
+					float3 normal = ( q0 - pos ) ^ ( q1 - pos );
+					float denom = ( descent ^ ( q1 - q0 ) ) * normal;
+					float s = denom != 0.0f ? ( ( q0 - pos ) ^ ( q1 - q0 ) ) * normal / denom : 0.0f;
+					float3 exit = pos + descent * s;
+					path.push_back( exit );
+					uint32_t adjFace = mesh.getAdjacentFace( opposite );
+					if( adjFace == Mesh::INVALID )
+					{
+						return;
+					}
+					face = adjFace;
+					continue;
+				}
+				if( lowest == vertex )
+				{
+					return;
+				}
+				vertex = lowest;
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			// Inside a face: march along the descent direction to the first edge it hits
+			float3 start = path.back();
+			float3 descent = -getGradient( face );
+			uint32_t hedge = mesh.aFaceHalfEdge[ face ];
+			uint32_t exitHedge = NONE;
+			float exitS = FLT_MAX;
+			ito( 3 )
+			{
+				float3 q0 = mesh.getOrigin( hedge ) , q1 = mesh.aPositions[ mesh.getEnd( hedge ) ];
+				float3 normal = ( q1 - q0 ) ^ ( mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ) - q0 );
+				float denom = ( descent ^ ( q1 - q0 ) ) * normal;
+				if( denom > 0.0f )
+				{
+					float s = ( ( q0 - start ) ^ ( q1 - q0 ) ) * normal / denom;
+					if( s < exitS )
+					{
+						exitS = s;
+						exitHedge = hedge;
+					}
+				}
+				hedge = mesh.aHalfEdgeNext[ hedge ];
+			}
+			uint32_t adjFace = exitHedge == NONE ? Mesh::INVALID : mesh.getAdjacentFace( exitHedge );
+			if( adjFace == Mesh::INVALID || exitS <= 0.0f || descent * descent == 0.0f )
+			{
+				// Stuck on an edge or against the boundary, fall back to the face's lowest vertex
+				uint32_t lowest = NONE;
+				hedge = mesh.aFaceHalfEdge[ face ];
+				ito( 3 )
+				{
+					uint32_t candidate = mesh.aHalfEdgeOrigin[ hedge ];
+					lowest = lowest == NONE || aDist[ candidate ] < aDist[ lowest ] ? candidate : lowest;
+					hedge = mesh.aHalfEdgeNext[ hedge ];
+				}
+				vertex = lowest;
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			float3 exit = start + descent * exitS;
+			path.push_back( exit );
+			// Descent in the next face pointing straight back means a valley along the edge
+			float3 nextDescent = -getGradient( adjFace );
+			uint32_t twin = mesh.aHalfEdgeTwin[ exitHedge ];
+			float3 q0 = mesh.getOrigin( twin ) , q1 = mesh.aPositions[ mesh.getEnd( twin ) ];
+			float3 adjNormal = ( q1 - q0 ) ^ ( mesh.getOrigin( mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ twin ] ] ) - q0 );
+			if( ( nextDescent ^ ( q1 - q0 ) ) * adjNormal >= 0.0f )
+			{
+				vertex = aDist[ mesh.aHalfEdgeOrigin[ twin ] ] < aDist[ mesh.getEnd( twin ) ] ? mesh.aHalfEdgeOrigin[ twin ] : mesh.getEnd( twin );
+				path.push_back( mesh.aPositions[ vertex ] );
+				continue;
+			}
+			face = adjFace;
+		}
+	}
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+// D-ary min-heap over item indices [ 0 , itemCount ) with decrease-key.
+// Keys live next to the heap slots so sifting touches one contiguous array.
+template< int D >
+struct IndexedHeap
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	struct Slot
+	{
+		float key;
+		uint32_t item;
+	};
+	std::vector< Slot > aSlots;
+	std::vector< uint32_t > aPosition;
+	void init( uint32_t itemCount )
+	{
+		aSlots.clear();
+		aPosition.assign( itemCount , NONE );
+	}
+	bool empty() const
+	{
+		return aSlots.empty();
+	}
+	uint32_t size() const
+	{
+		return uint32_t( aSlots.size() );
+	}
+	bool contains( uint32_t item ) const
+	{
+		return aPosition[ item ] != NONE;
+	}
+	float getKey( uint32_t item ) const
+	{
+		return aSlots[ aPosition[ item ] ].key;
+	}
+	float getTopKey() const
+	{
+		return aSlots[ 0 ].key;
+	}
+	uint32_t getTop() const
+	{
+		return aSlots[ 0 ].item;
+	}
+	void push( uint32_t item , float key )
+	{
+		aSlots.push_back( { key , item } );
+		siftUp( uint32_t( aSlots.size() - 1 ) );
+	}
+	void decrease( uint32_t item , float key )
+	{
+		uint32_t pos = aPosition[ item ];
+		aSlots[ pos ].key = key;
+		siftUp( pos );
+	}
+	// Returns true if the item was not in the heap before
+	bool pushOrDecrease( uint32_t item , float key )
+	{
+		if( contains( item ) )
+		{
+			decrease( item , key );
+			return false;
+		}
+		push( item , key );
+		return true;
+	}
+	uint32_t pop()
+	{
+		uint32_t item = aSlots[ 0 ].item;
+		aPosition[ item ] = NONE;
+		Slot last = aSlots.back();
+		aSlots.pop_back();
+		if( !aSlots.empty() )
+		{
+			aSlots[ 0 ] = last;
+			siftDown( 0 );
+		}
+		return item;
+	}
+	// Empties the heap in O( size ) without touching the whole position array
+	void clear()
+	{
+		for( auto const &slot : aSlots )
+		{
+			aPosition[ slot.item ] = NONE;
+		}
+		aSlots.clear();
+	}
+	void siftUp( uint32_t pos )
+	{
+		Slot slot = aSlots[ pos ];
+		while( pos > 0 )
+		{
+			uint32_t parent = ( pos - 1 ) / D;
+			if( aSlots[ parent ].key <= slot.key )
+			{
+				break;
+			}
+			aSlots[ pos ] = aSlots[ parent ];
+			aPosition[ aSlots[ pos ].item ] = pos;
+			pos = parent;
+		}
+		aSlots[ pos ] = slot;
+		aPosition[ slot.item ] = pos;
+	}
+	void siftDown( uint32_t pos )
+	{
+		Slot slot = aSlots[ pos ];
+		uint32_t count = uint32_t( aSlots.size() );
+		while( true )
+		{
+			uint32_t first = pos * D + 1;
+			if( first >= count )
+			{
+				break;
+			}
+			uint32_t last = first + D < count ? first + D : count;
+			uint32_t best = first;
+			for( uint32_t child = first + 1; child < last; child++ )
+			{
+				if( aSlots[ child ].key < aSlots[ best ].key )
+				{
+					best = child;
+				}
+			}
+			if( slot.key <= aSlots[ best ].key )
+			{
+				break;
+			}
+			aSlots[ pos ] = aSlots[ best ];
+			aPosition[ aSlots[ pos ].item ] = pos;
+			pos = best;
+		}
+		aSlots[ pos ] = slot;
+		aPosition[ slot.item ] = pos;
+	}
+};
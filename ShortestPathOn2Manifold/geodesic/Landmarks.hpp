@@ -0,0 +1,244 @@
+#pragma once
+#include "geodesic/DualGraph.hpp"
+#include "geodesic/IndexedHeap.hpp"
+#include <float.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+struct LandmarksStats
+{
+	uint32_t landmarks = 0;
+	double seconds = 0.0;
+};
+// ALT preprocessing: exact dual graph distances from every face to K landmark faces. For any faces
+// u and t and landmark L the triangle inequality gives d( u , t ) >= | d( L , u ) - d( L , t ) |,
+// the largest of these bounds steers A* far better than the straight line to the target.
+// Distances are stored face-major so one face reads all its landmarks from a single row.
+struct Landmarks
+{
+	enum Selection : uint32_t
+	{
+		FARTHEST ,
+		RANDOM
+	};
+	enum : uint32_t
+	{
+		// "ALT1" at the start of a saved table
+		MAGIC = 0x31544c41u
+	};
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	uint64_t graphHash = 0;
+	uint32_t faceCount = 0;
+	std::vector< uint32_t > aLandmarkFaces;
+	// aDist[ face * landmark count + landmark ], FLT_MAX if the landmark does not reach the face
+	std::vector< float > aDist;
+	// Absolute slack for the rounding of the float distance sums
+	float tolerance = 0.0f;
+	LandmarksStats stats;
+	uint32_t getLandmarkCount() const
+	{
+		return uint32_t( aLandmarkFaces.size() );
+	}
+	bool isValid( DualGraph const &graph ) const
+	{
+		return !aLandmarkFaces.empty() && pMesh == graph.pMesh && meshVersion == graph.meshVersion;
+	}
+	// FNV-1a over the arcs, ties saved tables to the connectivity and weights they were computed on
+	static uint64_t getGraphHash( DualGraph const &graph )
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [ &hash ]( uint32_t value )
+		{
+			ito( 4 )
+			{
+				hash = ( hash ^ ( ( value >> ( i * 8 ) ) & 0xff ) ) * 1099511628211ull;
+			}
+		};
+		mix( graph.getFaceCount() );
+		for( uint32_t arc = 0; arc < graph.getArcCount(); arc++ )
+		{
+			uint32_t weightBits;
+			memcpy( &weightBits , &graph.aArcWeight[ arc ] , 4 );
+			mix( graph.aArcFace[ arc ] );
+			mix( weightBits );
+		}
+		return hash;
+	}
+	// One Dijkstra flood per landmark, plus one to seed farthest point sampling
+	void build( DualGraph const &graph , uint32_t landmarkCount , Selection selection , uint32_t seed = 1 )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		pMesh = graph.pMesh;
+		meshVersion = graph.meshVersion;
+		graphHash = getGraphHash( graph );
+		faceCount = graph.getFaceCount();
+		landmarkCount = std::min( landmarkCount , faceCount );
+		aLandmarkFaces.clear();
+		aDist.assign( size_t( faceCount ) * landmarkCount , FLT_MAX );
+		tolerance = 0.0f;
+		if( faceCount == 0 )
+		{
+			stats.landmarks = 0;
+			stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			return;
+		}
+		std::mt19937 random( seed );
+		// Farthest point sampling: the first flood starts from a random face and is thrown away,
+		// each landmark is then the face farthest from all landmarks so far
+		std::vector< float > aMinDist;
+		std::vector< float > aFlood;
+		IndexedHeap< 4 > heap;
+		heap.init( faceCount );
+		uint32_t nextFace = random() % faceCount;
+		if( selection == FARTHEST )
+		{
+			flood( graph , nextFace , heap , aFlood );
+			aMinDist.resize( faceCount );
+			nextFace = getFarthest( aFlood , aMinDist , true );
+		}
+		float maxDist = 0.0f;
+		while( aLandmarkFaces.size() < landmarkCount )
+		{
+			uint32_t landmark = getLandmarkCount();
+			aLandmarkFaces.push_back( nextFace );
+			flood( graph , nextFace , heap , aFlood );
+			for( uint32_t face = 0; face < faceCount; face++ )
+			{
+				float dist = aFlood[ face ];
+				aDist[ size_t( face ) * landmarkCount + landmark ] = dist;
+				if( dist != FLT_MAX )
+				{
+					maxDist = std::max( maxDist , dist );
+				}
+			}
+			if( selection == FARTHEST )
+			{
+				nextFace = getFarthest( aFlood , aMinDist , landmark == 0 );
+			} else if( aLandmarkFaces.size() < landmarkCount )
+			{
+				// Redrawn on a repeat, landmarkCount is at most faceCount so a free face is left
+				do
+				{
+					nextFace = random() % faceCount;
+				} while( std::find( aLandmarkFaces.begin() , aLandmarkFaces.end() , nextFace ) != aLandmarkFaces.end() );
+			}
+		}
+		tolerance = maxDist * 1e-5f;
+		stats.landmarks = getLandmarkCount();
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Lower bound on the dual graph distance between the centroids of two faces
+	float getLowerBound( uint32_t face , uint32_t targetFace ) const
+	{
+		uint32_t landmarkCount = getLandmarkCount();
+		float const *pFaceRow = &aDist[ size_t( face ) * landmarkCount ];
+		float const *pTargetRow = &aDist[ size_t( targetFace ) * landmarkCount ];
+		float bound = 0.0f;
+		for( uint32_t i = 0; i < landmarkCount; i++ )
+		{
+			bound = std::max( bound , fabsf( pFaceRow[ i ] - pTargetRow[ i ] ) );
+		}
+		return bound - tolerance;
+	}
+	// Tables are saved next to the mesh, e.g. test.obj.landmarks, and only loaded back onto the
+	// same graph
+	bool save( char const *path ) const
+	{
+		FILE *file = fopen( path , "wb" );
+		if( !file )
+		{
+			return false;
+		}
+		uint32_t landmarkCount = getLandmarkCount();
+		uint32_t const aHeader[] = { MAGIC , faceCount , landmarkCount };
+		bool written = fwrite( aHeader , sizeof( aHeader ) , 1 , file ) == 1 &&
+			fwrite( &graphHash , sizeof( graphHash ) , 1 , file ) == 1 &&
+			fwrite( &tolerance , sizeof( tolerance ) , 1 , file ) == 1 &&
+			fwrite( aLandmarkFaces.data() , sizeof( uint32_t ) , landmarkCount , file ) == landmarkCount &&
+			fwrite( aDist.data() , sizeof( float ) , aDist.size() , file ) == aDist.size();
+		fclose( file );
+		return written;
+	}
+	// Returns false and leaves the tables empty if the file is missing or was saved for another graph
+	bool load( char const *path , DualGraph const &graph )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		aLandmarkFaces.clear();
+		aDist.clear();
+		FILE *file = fopen( path , "rb" );
+		if( !file )
+		{
+			return false;
+		}
+		uint32_t aHeader[ 3 ];
+		uint64_t savedHash;
+		bool loaded = fread( aHeader , sizeof( aHeader ) , 1 , file ) == 1 &&
+			fread( &savedHash , sizeof( savedHash ) , 1 , file ) == 1 &&
+			aHeader[ 0 ] == MAGIC && aHeader[ 1 ] == graph.getFaceCount() && aHeader[ 2 ] > 0 &&
+			aHeader[ 2 ] <= aHeader[ 1 ] && savedHash == getGraphHash( graph );
+		if( loaded )
+		{
+			uint32_t landmarkCount = aHeader[ 2 ];
+			aLandmarkFaces.resize( landmarkCount );
+			aDist.resize( size_t( aHeader[ 1 ] ) * landmarkCount );
+			loaded = fread( &tolerance , sizeof( tolerance ) , 1 , file ) == 1 &&
+				fread( aLandmarkFaces.data() , sizeof( uint32_t ) , landmarkCount , file ) == landmarkCount &&
+				fread( aDist.data() , sizeof( float ) , aDist.size() , file ) == aDist.size();
+		}
+		fclose( file );
+		if( !loaded )
+		{
+			aLandmarkFaces.clear();
+			aDist.clear();
+			return false;
+		}
+		pMesh = graph.pMesh;
+		meshVersion = graph.meshVersion;
+		graphHash = savedHash;
+		faceCount = aHeader[ 1 ];
+		stats.landmarks = getLandmarkCount();
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		return true;
+	}
+	// Centroid to centroid distances from sourceFace, FLT_MAX where it does not reach
+	static void flood( DualGraph const &graph , uint32_t sourceFace , IndexedHeap< 4 > &heap , std::vector< float > &aFlood )
+	{
+		aFlood.assign( graph.getFaceCount() , FLT_MAX );
+		heap.clear();
+		aFlood[ sourceFace ] = 0.0f;
+		heap.push( sourceFace , 0.0f );
+		while( !heap.empty() )
+		{
+			uint32_t face = heap.pop();
+			for( uint32_t arc = graph.aOffsets[ face ]; arc < graph.aOffsets[ face + 1 ]; arc++ )
+			{
+				uint32_t adjFace = graph.aArcFace[ arc ];
+				float dist = aFlood[ face ] + graph.aArcWeight[ arc ];
+				if( dist < aFlood[ adjFace ] )
+				{
+					aFlood[ adjFace ] = dist;
+					heap.pushOrDecrease( adjFace , dist );
+				}
+			}
+		}
+	}
+	// Folds the last flood into aMinDist and returns the face farthest from every landmark so far,
+	// unreached faces first so each connected component gets a landmark
+	uint32_t getFarthest( std::vector< float > const &aFlood , std::vector< float > &aMinDist , bool first ) const
+	{
+		uint32_t farthest = 0;
+		for( uint32_t face = 0; face < faceCount; face++ )
+		{
+			float dist = aFlood[ face ];
+			aMinDist[ face ] = first ? dist : std::min( aMinDist[ face ] , dist );
+			if( aMinDist[ face ] > aMinDist[ farthest ] )
+			{
+				farthest = face;
+			}
+		}
+		return farthest;
+	}
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include "geodesic/BidirectionalSearch.hpp"
+#include "geodesic/ContractionHierarchy.hpp"
+#include "geodesic/CorridorFunnel.hpp"
+#include "geodesic/CollisionRefine.hpp"
+#include <algorithm>
+#include <chrono>
+struct PathResult
+{
+	// FLT_MAX and an empty path if the target is unreachable
+	float distance = FLT_MAX;
+	// Surface polyline from the source point to the target point
+	std::vector< float3 > path;
+};
+struct QueryStats
+{
+	FaceSearchStats search;
+	CorridorFunnelStats funnel;
+	CollisionRefineStats refine;
+	double seconds = 0.0;
+};
+// Everything a point-to-point query writes: search labels and heaps, the face corridor and the edge
+// collisions of the path. Mesh and DualGraph are only read, so once the graph is up to date any number
+// of contexts can answer queries on the same mesh concurrently, one context per thread and no locks.
+struct QueryContext
+{
+	enum Method : uint32_t
+	{
+		ASTAR ,
+		FLOOD ,
+		BIDIRECTIONAL ,
+		// A* with landmark bounds, plain A* while pLandmarks is not set or stale
+		ALT ,
+		// Upward search in pHierarchy, plain A* while it is not set or stale
+		HIERARCHY
+	};
+	FaceSearch faceSearch;
+	BidirectionalSearch bidirectionalSearch;
+	ContractionHierarchySearch hierarchySearch;
+	CorridorFunnel corridorFunnel;
+	CollisionRefine collisionRefine;
+	SearchEndpoints endpoints;
+	// Faces from the target back to the source
+	std::vector< uint32_t > corridor;
+	// Path crossings in the same order, the path runs targetPoint -> collisions -> sourcePoint
+	std::vector< Collision > collisions;
+	float length = FLT_MAX;
+	QueryStats stats;
+	Landmarks const *pLandmarks = nullptr;
+	ContractionHierarchy const *pHierarchy = nullptr;
+	// Returns false if the target cannot be reached from the source
+	bool run( Mesh const &mesh , DualGraph const &graph , SearchEndpoints const &endpoints , Method method )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		FaceSearchStats searchStats;
+		if( method == BIDIRECTIONAL )
+		{
+			bidirectionalSearch.run( graph , endpoints );
+			bidirectionalSearch.getCorridor( corridor );
+			searchStats = bidirectionalSearch.stats;
+		} else if( method == HIERARCHY && pHierarchy && pHierarchy->isValid( graph ) )
+		{
+			hierarchySearch.run( graph , *pHierarchy , endpoints );
+			hierarchySearch.getCorridor( *pHierarchy , corridor );
+			searchStats = hierarchySearch.stats;
+		} else
+		{
+			bool useLandmarks = method == ALT && pLandmarks && pLandmarks->isValid( graph );
+			faceSearch.run( graph , endpoints , method == FLOOD , useLandmarks ? pLandmarks : nullptr );
+			faceSearch.getCorridor( corridor );
+			searchStats = faceSearch.stats;
+		}
+		bool reached = runCorridor( mesh , endpoints );
+		stats.search = searchStats;
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		return reached;
+	}
+	// Straightens a corridor already filled in by the caller, e.g. extracted from a kept search tree
+	bool runCorridor( Mesh const &mesh , SearchEndpoints const &endpoints )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		this->endpoints = endpoints;
+		stats = QueryStats();
+		collisions.clear();
+		length = FLT_MAX;
+		if( !corridor.empty() )
+		{
+			corridorFunnel.run( mesh , corridor , endpoints.targetPoint , endpoints.sourcePoint );
+			stats.funnel = corridorFunnel.stats;
+			for( size_t i = 0; i + 1 < corridor.size(); i++ )
+			{
+				uint32_t hedge = corridorFunnel.aPortalHalfEdge[ i ];
+				collisions.push_back( { mesh.getEdgeNormal( hedge ) , mesh.getOrigin( hedge ) , corridorFunnel.aCrossings[ i ] , mesh.getEdgeLength( hedge ) } );
+			}
+			// Polishes the float rounding of the funnel crossings
+			stats.refine = collisionRefine.run( endpoints.targetPoint , endpoints.sourcePoint , collisions );
+			length = float( CollisionRefine::getLength( endpoints.targetPoint , endpoints.sourcePoint , collisions ) );
+		}
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		return !corridor.empty();
+	}
+	// Polyline from the target point through the collisions to the source point
+	void getPath( std::vector< float3 > &path ) const
+	{
+		path.clear();
+		if( corridor.empty() )
+		{
+			return;
+		}
+		path.push_back( endpoints.targetPoint );
+		for( auto const &col : collisions )
+		{
+			path.push_back( col.getPos() );
+		}
+		path.push_back( endpoints.sourcePoint );
+	}
+	void getResult( PathResult &result ) const
+	{
+		result.distance = length;
+		getPath( result.path );
+		std::reverse( result.path.begin() , result.path.end() );
+	}
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include "geodesic/QueryContext.hpp"
+#include "geodesic/SourceTree.hpp"
+#include <memory>
+// One full search from a source point, then any number of targets answered by walking the kept tree
+// back to the source and straightening the corridor, with no further search. The tree is held until
+// release() or the next setSource() and may be shared read-only with other queries through setTree(),
+// for instance from a SourceTreeCache.
+struct SingleSourceQuery
+{
+	FaceSearch faceSearch;
+	QueryContext query;
+	std::shared_ptr< SourceTree const > pTree;
+	// graph must be up to date for the mesh the targets are queried on
+	void setSource( DualGraph const &graph , uint32_t sourceFace , float3 const &sourcePoint )
+	{
+		std::shared_ptr< SourceTree > pNewTree = std::make_shared< SourceTree >();
+		pNewTree->build( graph , sourceFace , sourcePoint , faceSearch );
+		pTree = pNewTree;
+	}
+	void setTree( std::shared_ptr< SourceTree const > const &pTree )
+	{
+		this->pTree = pTree;
+	}
+	bool hasSource() const
+	{
+		return pTree != nullptr;
+	}
+	void release()
+	{
+		pTree.reset();
+	}
+	// Returns false if there is no source or the target is not reachable from it
+	bool run( Mesh const &mesh , uint32_t targetFace , float3 const &targetPoint , PathResult &result )
+	{
+		if( !pTree )
+		{
+			result = PathResult();
+			return false;
+		}
+		SearchEndpoints endpoints;
+		endpoints.sourceFace = pTree->sourceFace;
+		endpoints.sourcePoint = pTree->sourcePoint;
+		endpoints.targetFace = targetFace;
+		endpoints.targetPoint = targetPoint;
+		pTree->getCorridor( targetFace , query.corridor );
+		bool reached = query.runCorridor( mesh , endpoints );
+		query.getResult( result );
+		return reached;
+	}
+};
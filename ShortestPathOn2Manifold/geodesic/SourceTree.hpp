@@ -0,0 +1,57 @@
+#pragma once
+#include "geodesic/FaceSearch.hpp"
+#include <chrono>
+// Shortest path tree over the dual graph from one source point, the result of a full flood kept as
+// plain arrays so it outlives the search that grew it. Arcs leaving the source face are anchored at
+// the source point, every other face at its centroid.
+struct SourceTree
+{
+	uint32_t sourceFace = Mesh::INVALID;
+	float3 sourcePoint;
+	std::vector< float > aDist;
+	std::vector< uint32_t > aFrom;
+	FaceSearchStats stats;
+	double seconds = 0.0;
+	// faceSearch is scratch, its labels are copied out once the flood is done
+	void build( DualGraph const &graph , uint32_t sourceFace , float3 const &sourcePoint , FaceSearch &faceSearch )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		this->sourceFace = sourceFace;
+		this->sourcePoint = sourcePoint;
+		SearchEndpoints endpoints;
+		endpoints.sourceFace = sourceFace;
+		endpoints.sourcePoint = sourcePoint;
+		faceSearch.run( graph , endpoints , true );
+		uint32_t faceCount = graph.getFaceCount();
+		aDist.resize( faceCount );
+		aFrom.resize( faceCount );
+		for( uint32_t face = 0; face < faceCount; face++ )
+		{
+			aDist[ face ] = faceSearch.labels.getDist( face );
+			aFrom[ face ] = faceSearch.labels.getFrom( face );
+		}
+		stats = faceSearch.stats;
+		seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	bool isReached( uint32_t face ) const
+	{
+		return aDist[ face ] != FLT_MAX;
+	}
+	// Faces from targetFace back to the source, same order as FaceSearch::getCorridor
+	void getCorridor( uint32_t targetFace , std::vector< uint32_t > &aCorridor ) const
+	{
+		aCorridor.clear();
+		if( !isReached( targetFace ) )
+		{
+			return;
+		}
+		for( uint32_t face = targetFace; face != Mesh::INVALID; face = aFrom[ face ] )
+		{
+			aCorridor.push_back( face );
+		}
+	}
+	size_t getByteSize() const
+	{
+		return sizeof( SourceTree ) + aDist.capacity() * sizeof( float ) + aFrom.capacity() * sizeof( uint32_t );
+	}
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include "geodesic/SourceTree.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+struct SourceTreeCacheStats
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t bytes = 0;
+	uint32_t entries = 0;
+};
+// Least recently used source trees keyed by source face, within a byte budget. The first arcs of a tree
+// depend on the point it was grown from, so a hit needs the same point and another point on the face
+// replaces the entry. Trees are handed out as shared pointers, evicting one never pulls it from under a
+// caller. Lookups lock, trees are grown outside the lock so a miss does not stall other threads.
+struct SourceTreeCache
+{
+	struct Entry
+	{
+		uint32_t sourceFace;
+		std::shared_ptr< SourceTree const > pTree;
+		size_t bytes;
+	};
+	size_t byteBudget;
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	// Most recently used first
+	std::list< Entry > lru;
+	std::unordered_map< uint32_t , std::list< Entry >::iterator > entryMap;
+	SourceTreeCacheStats stats;
+	std::mutex mutex;
+	explicit SourceTreeCache( size_t byteBudget = size_t( 256 ) << 20 ) :
+		byteBudget( byteBudget )
+	{
+	}
+	void clear()
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		lru.clear();
+		entryMap.clear();
+		stats.bytes = 0;
+		stats.entries = 0;
+	}
+	// Tree of sourcePoint on sourceFace, grown with faceSearch as scratch on a miss. Entries of an older mesh are dropped.
+	std::shared_ptr< SourceTree const > get( DualGraph const &graph , uint32_t sourceFace , float3 const &sourcePoint , FaceSearch &faceSearch )
+	{
+		{
+			std::lock_guard< std::mutex > lock( mutex );
+			if( pMesh != graph.pMesh || meshVersion != graph.meshVersion )
+			{
+				lru.clear();
+				entryMap.clear();
+				stats.bytes = 0;
+				stats.entries = 0;
+				pMesh = graph.pMesh;
+				meshVersion = graph.meshVersion;
+			}
+			auto found = entryMap.find( sourceFace );
+			if( found != entryMap.end() && found->second->pTree->sourcePoint == sourcePoint )
+			{
+				stats.hits++;
+				lru.splice( lru.begin() , lru , found->second );
+				return found->second->pTree;
+			}
+			stats.misses++;
+		}
+		std::shared_ptr< SourceTree > pTree = std::make_shared< SourceTree >();
+		pTree->build( graph , sourceFace , sourcePoint , faceSearch );
+		insert( sourceFace , pTree );
+		return pTree;
+	}
+	void insert( uint32_t sourceFace , std::shared_ptr< SourceTree const > const &pTree )
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		// Another thread may have grown the same tree meanwhile, a tree of another point is replaced
+		auto found = entryMap.find( sourceFace );
+		if( found != entryMap.end() )
+		{
+			if( found->second->pTree->sourcePoint == pTree->sourcePoint )
+			{
+				return;
+			}
+			stats.bytes -= found->second->bytes;
+			lru.erase( found->second );
+			entryMap.erase( found );
+		}
+		size_t bytes = pTree->getByteSize();
+		if( bytes > byteBudget )
+		{
+			return;
+		}
+		while( stats.bytes + bytes > byteBudget )
+		{
+			Entry const &oldest = lru.back();
+			stats.bytes -= oldest.bytes;
+			entryMap.erase( oldest.sourceFace );
+			lru.pop_back();
+			stats.evictions++;
+		}
+		lru.push_front( { sourceFace , pTree , bytes } );
+		entryMap[ sourceFace ] = lru.begin();
+		stats.bytes += bytes;
+		stats.entries = uint32_t( lru.size() );
+	}
+	SourceTreeCacheStats getStats()
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		stats.entries = uint32_t( lru.size() );
+		return stats;
+	}
+};
@@ -0,0 +1,274 @@
+#pragma once
+#include "geodesic/SparseMatrix.hpp"
+#include <chrono>
+struct SparseLDLTStats
+{
+	uint32_t factorNonZeros = 0;
+	double orderSeconds = 0.0;
+	double factorSeconds = 0.0;
+};
+// Simplicial up-looking LDL^T factorization of a symmetric positive definite matrix, P A P^T = L D L^T.
+// Rows are permuted by nested dissection to keep the fill of L low, the symbolic pass walks the
+// elimination tree to size the columns of L before the numeric pass fills them row by row.
+struct SparseLDLT
+{
+	enum : uint32_t { NONE = 0xffffffffu };
+	uint32_t size = 0;
+	// aPerm[ k ] is the original row eliminated k-th, aPermInv is its inverse
+	std::vector< uint32_t > aPerm;
+	std::vector< uint32_t > aPermInv;
+	std::vector< uint32_t > aParent;
+	// Strictly lower part of L by column
+	std::vector< uint32_t > aColumnOffsets;
+	std::vector< uint32_t > aRows;
+	std::vector< double > aValues;
+	std::vector< double > aDiag;
+	SparseLDLTStats stats;
+	// Nested dissection on the adjacency graph of the matrix. A part is split by the middle level of a
+	// breadth-first search from a pseudo-peripheral vertex, the separator level is eliminated after both halves.
+	static void computeOrdering( SparseMatrix const &matrix , std::vector< uint32_t > &aOrder )
+	{
+		struct Part
+		{
+			uint32_t begin , count , id;
+		};
+		uint32_t const LEAF_SIZE = 64;
+		uint32_t n = matrix.size;
+		aOrder.resize( n );
+		for( uint32_t i = 0; i < n; i++ )
+		{
+			aOrder[ i ] = i;
+		}
+		std::vector< uint32_t > aPart( n , 0 );
+		std::vector< uint32_t > aStamp( n , 0 );
+		std::vector< uint32_t > aLevel( n , 0 );
+		std::vector< uint32_t > aQueue , aLevelCount , aScratch;
+		uint32_t stamp = 0 , partCount = 1;
+		auto bfs = [ & ]( uint32_t root , uint32_t id )
+		{
+			stamp++;
+			aQueue.clear();
+			aQueue.push_back( root );
+			aStamp[ root ] = stamp;
+			aLevel[ root ] = 0;
+			for( size_t head = 0; head < aQueue.size(); head++ )
+			{
+				uint32_t row = aQueue[ head ];
+				for( uint32_t i = matrix.aOffsets[ row ]; i < matrix.aOffsets[ row + 1 ]; i++ )
+				{
+					uint32_t column = matrix.aColumns[ i ];
+					if( aPart[ column ] == id && aStamp[ column ] != stamp )
+					{
+						aStamp[ column ] = stamp;
+						aLevel[ column ] = aLevel[ row ] + 1;
+						aQueue.push_back( column );
+					}
+				}
+			}
+		};
+		std::vector< Part > aStack;
+		if( n > 0 )
+		{
+			aStack.push_back( { 0 , n , 0 } );
+		}
+		while( !aStack.empty() )
+		{
+			Part part = aStack.back();
+			aStack.pop_back();
+			if( part.count <= LEAF_SIZE )
+			{
+				continue;
+			}
+			bfs( aOrder[ part.begin ] , part.id );
+			bfs( aQueue.back() , part.id );
+			uint32_t levelCount = aLevel[ aQueue.back() ] + 1;
+			// Another component first, the reached one is split on a later pass
+			if( aQueue.size() < part.count || levelCount < 3 )
+			{
+				if( aQueue.size() < part.count )
+				{
+					aScratch.assign( aQueue.begin() , aQueue.end() );
+					for( uint32_t i = part.begin; i < part.begin + part.count; i++ )
+					{
+						if( aStamp[ aOrder[ i ] ] != stamp )
+						{
+							aScratch.push_back( aOrder[ i ] );
+						}
+					}
+					std::copy( aScratch.begin() , aScratch.end() , aOrder.begin() + part.begin );
+					uint32_t reached = uint32_t( aQueue.size() );
+					for( uint32_t i = part.begin + reached; i < part.begin + part.count; i++ )
+					{
+						aPart[ aOrder[ i ] ] = partCount;
+					}
+					aStack.push_back( { part.begin + reached , part.count - reached , partCount++ } );
+					aStack.push_back( { part.begin , reached , part.id } );
+				}
+				continue;
+			}
+			aLevelCount.assign( levelCount , 0 );
+			for( uint32_t row : aQueue )
+			{
+				aLevelCount[ aLevel[ row ] ]++;
+			}
+			uint32_t middle = 1 , below = aLevelCount[ 0 ];
+			while( middle + 2 < levelCount && below + aLevelCount[ middle ] < part.count / 2 )
+			{
+				below += aLevelCount[ middle++ ];
+			}
+			uint32_t above = part.count - below - aLevelCount[ middle ];
+			uint32_t lowId = partCount++ , highId = partCount++;
+			uint32_t lowFill = part.begin , highFill = part.begin + below , separatorFill = highFill + above;
+			for( uint32_t row : aQueue )
+			{
+				if( aLevel[ row ] < middle )
+				{
+					aPart[ row ] = lowId;
+					aOrder[ lowFill++ ] = row;
+				} else if( aLevel[ row ] > middle )
+				{
+					aPart[ row ] = highId;
+					aOrder[ highFill++ ] = row;
+				} else
+				{
+					aPart[ row ] = NONE;
+					aOrder[ separatorFill++ ] = row;
+				}
+			}
+			aStack.push_back( { part.begin , below , lowId } );
+			aStack.push_back( { part.begin + below , above , highId } );
+		}
+	}
+	// Returns false if a zero pivot shows up, i.e. the matrix is singular
+	bool factor( SparseMatrix const &matrix )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		size = matrix.size;
+		computeOrdering( matrix , aPerm );
+		aPermInv.resize( size );
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			aPermInv[ aPerm[ k ] ] = k;
+		}
+		auto ordered = std::chrono::high_resolution_clock::now();
+		stats.orderSeconds = std::chrono::duration< double >( ordered - start ).count();
+		// Symbolic: elimination tree and column counts of L
+		std::vector< uint32_t > aFlag( size );
+		std::vector< uint32_t > aColumnCount( size );
+		aParent.assign( size , NONE );
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			aFlag[ k ] = k;
+			aColumnCount[ k ] = 0;
+			uint32_t row = aPerm[ k ];
+			for( uint32_t p = matrix.aOffsets[ row ]; p < matrix.aOffsets[ row + 1 ]; p++ )
+			{
+				for( uint32_t i = aPermInv[ matrix.aColumns[ p ] ]; i < k && aFlag[ i ] != k; i = aParent[ i ] )
+				{
+					if( aParent[ i ] == NONE )
+					{
+						aParent[ i ] = k;
+					}
+					aColumnCount[ i ]++;
+					aFlag[ i ] = k;
+				}
+			}
+		}
+		aColumnOffsets.resize( size + 1 );
+		aColumnOffsets[ 0 ] = 0;
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			aColumnOffsets[ k + 1 ] = aColumnOffsets[ k ] + aColumnCount[ k ];
+		}
+		uint32_t nonZeroCount = aColumnOffsets[ size ];
+		aRows.resize( nonZeroCount );
+		aValues.resize( nonZeroCount );
+		aDiag.resize( size );
+		// Numeric: row k of L comes from a sparse triangular solve over the pattern reached in the tree
+		std::vector< double > aY( size , 0.0 );
+		std::vector< uint32_t > aPattern( size );
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			uint32_t top = size;
+			aFlag[ k ] = k;
+			aColumnCount[ k ] = 0;
+			uint32_t row = aPerm[ k ];
+			for( uint32_t p = matrix.aOffsets[ row ]; p < matrix.aOffsets[ row + 1 ]; p++ )
+			{
+				uint32_t i = aPermInv[ matrix.aColumns[ p ] ];
+				if( i > k )
+				{
+					continue;
+				}
+				aY[ i ] += matrix.aValues[ p ];
+				uint32_t length = 0;
+				for( ; aFlag[ i ] != k; i = aParent[ i ] )
+				{
+					aPattern[ length++ ] = i;
+					aFlag[ i ] = k;
+				}
+				while( length > 0 )
+				{
+					aPattern[ --top ] = aPattern[ --length ];
+				}
+			}
+			double diag = aY[ k ];
+			aY[ k ] = 0.0;
+			for( ; top < size; top++ )
+			{
+				uint32_t i = aPattern[ top ];
+				double yi = aY[ i ];
+				aY[ i ] = 0.0;
+				uint32_t end = aColumnOffsets[ i ] + aColumnCount[ i ];
+				for( uint32_t p = aColumnOffsets[ i ]; p < end; p++ )
+				{
+					aY[ aRows[ p ] ] -= aValues[ p ] * yi;
+				}
+				double lki = yi / aDiag[ i ];
+				diag -= lki * yi;
+				aRows[ end ] = k;
+				aValues[ end ] = lki;
+				aColumnCount[ i ]++;
+			}
+			if( diag == 0.0 )
+			{
+				return false;
+			}
+			aDiag[ k ] = diag;
+		}
+		stats.factorNonZeros = nonZeroCount;
+		stats.factorSeconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - ordered ).count();
+		return true;
+	}
+	// Solves A x = b in place
+	void solve( std::vector< double > &x ) const
+	{
+		std::vector< double > y( size );
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			y[ k ] = x[ aPerm[ k ] ];
+		}
+		for( uint32_t j = 0; j < size; j++ )
+		{
+			for( uint32_t p = aColumnOffsets[ j ]; p < aColumnOffsets[ j + 1 ]; p++ )
+			{
+				y[ aRows[ p ] ] -= aValues[ p ] * y[ j ];
+			}
+		}
+		for( uint32_t j = 0; j < size; j++ )
+		{
+			y[ j ] /= aDiag[ j ];
+		}
+		for( uint32_t j = size; j-- > 0; )
+		{
+			for( uint32_t p = aColumnOffsets[ j ]; p < aColumnOffsets[ j + 1 ]; p++ )
+			{
+				y[ j ] -= aValues[ p ] * y[ aRows[ p ] ];
+			}
+		}
+		for( uint32_t k = 0; k < size; k++ )
+		{
+			x[ aPerm[ k ] ] = y[ k ];
+		}
+	}
+};
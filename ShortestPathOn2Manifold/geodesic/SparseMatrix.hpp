@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+// Square sparse matrix in CSR form. Row r holds columns aColumns[ aOffsets[ r ] .. aOffsets[ r + 1 ] )
+// sorted ascending. Symmetric matrices store both triangles.
+struct SparseMatrix
+{
+	struct Triplet
+	{
+		uint32_t row;
+		uint32_t column;
+		double value;
+	};
+	uint32_t size = 0;
+	std::vector< uint32_t > aOffsets;
+	std::vector< uint32_t > aColumns;
+	std::vector< double > aValues;
+	uint32_t getNonZeroCount() const
+	{
+		return uint32_t( aColumns.size() );
+	}
+	// Sorts the triplets and sums duplicates
+	void build( uint32_t size , std::vector< Triplet > &aTriplets )
+	{
+		this->size = size;
+		std::sort( aTriplets.begin() , aTriplets.end() , []( Triplet const &a , Triplet const &b )
+		{
+			return a.row != b.row ? a.row < b.row : a.column < b.column;
+		} );
+		aOffsets.assign( size + 1 , 0 );
+		aColumns.clear();
+		aValues.clear();
+		for( size_t i = 0; i < aTriplets.size(); i++ )
+		{
+			Triplet const &triplet = aTriplets[ i ];
+			if( i > 0 && triplet.row == aTriplets[ i - 1 ].row && triplet.column == aTriplets[ i - 1 ].column )
+			{
+				aValues.back() += triplet.value;
+				continue;
+			}
+			aColumns.push_back( triplet.column );
+			aValues.push_back( triplet.value );
+			aOffsets[ triplet.row + 1 ]++;
+		}
+		for( uint32_t row = 0; row < size; row++ )
+		{
+			aOffsets[ row + 1 ] += aOffsets[ row ];
+		}
+	}
+	// y = A * x
+	void multiply( std::vector< double > const &x , std::vector< double > &y ) const
+	{
+		y.resize( size );
+#pragma omp parallel for
+		for( int row = 0; row < int( size ); row++ )
+		{
+			double sum = 0.0;
+			for( uint32_t i = aOffsets[ row ]; i < aOffsets[ row + 1 ]; i++ )
+			{
+				sum += aValues[ i ] * x[ aColumns[ i ] ];
+			}
+			y[ row ] = sum;
+		}
+	}
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// Persistent worker threads with one range deque each. A job is cut into grain-sized ranges dealt
+// round robin over the deques, a worker pops its own newest range first and steals the oldest range
+// of another worker once its deque runs dry, so uneven queries even out without a shared queue.
+// The calling thread works as worker 0 while it waits.
+struct WorkStealingPool
+{
+	struct Range
+	{
+		uint32_t begin , end;
+	};
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque< Range > aRanges;
+	};
+	// task( worker , begin , end ) handles the indices [ begin , end )
+	typedef std::function< void( uint32_t , uint32_t , uint32_t ) > Task;
+	std::vector< std::thread > aThreads;
+	std::vector< std::unique_ptr< Queue > > aQueues;
+	Task task;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint32_t generation = 0;
+	uint32_t busy = 0;
+	bool quit = false;
+	std::atomic< uint32_t > steals;
+	explicit WorkStealingPool( uint32_t threadCount = std::thread::hardware_concurrency() )
+	{
+		threadCount = threadCount > 0 ? threadCount : 1;
+		steals = 0;
+		for( uint32_t i = 0; i < threadCount; i++ )
+		{
+			aQueues.emplace_back( new Queue() );
+		}
+		for( uint32_t i = 1; i < threadCount; i++ )
+		{
+			aThreads.emplace_back( [ this , i ]()
+			{
+				work( i );
+			} );
+		}
+	}
+	~WorkStealingPool()
+	{
+		{
+			std::lock_guard< std::mutex > lock( mutex );
+			quit = true;
+		}
+		wake.notify_all();
+		for( auto &thread : aThreads )
+		{
+			thread.join();
+		}
+	}
+	uint32_t getThreadCount() const
+	{
+		return uint32_t( aQueues.size() );
+	}
+	// Runs task over [ 0 , count ) and returns once every range is done
+	void run( uint32_t count , uint32_t grain , Task const &task )
+	{
+		this->task = task;
+		grain = grain > 0 ? grain : 1;
+		uint32_t worker = 0;
+		for( uint32_t begin = 0; begin < count; begin += grain )
+		{
+			uint32_t end = count - begin > grain ? begin + grain : count;
+			aQueues[ worker ]->aRanges.push_back( { begin , end } );
+			worker = ( worker + 1 ) % getThreadCount();
+		}
+		{
+			std::lock_guard< std::mutex > lock( mutex );
+			busy = uint32_t( aThreads.size() );
+			generation++;
+		}
+		wake.notify_all();
+		drain( 0 );
+		std::unique_lock< std::mutex > lock( mutex );
+		done.wait( lock , [ this ]()
+		{
+			return busy == 0;
+		} );
+	}
+	void work( uint32_t worker )
+	{
+		uint32_t seen = 0;
+		std::unique_lock< std::mutex > lock( mutex );
+		while( true )
+		{
+			wake.wait( lock , [ & ]()
+			{
+				return quit || generation != seen;
+			} );
+			if( quit )
+			{
+				return;
+			}
+			seen = generation;
+			lock.unlock();
+			drain( worker );
+			lock.lock();
+			if( --busy == 0 )
+			{
+				done.notify_all();
+			}
+		}
+	}
+	bool pop( uint32_t queue , bool newest , Range &range )
+	{
+		Queue &victim = *aQueues[ queue ];
+		std::lock_guard< std::mutex > lock( victim.mutex );
+		if( victim.aRanges.empty() )
+		{
+			return false;
+		}
+		if( newest )
+		{
+			range = victim.aRanges.back();
+			victim.aRanges.pop_back();
+		} else
+		{
+			range = victim.aRanges.front();
+			victim.aRanges.pop_front();
+		}
+		return true;
+	}
+	// No ranges are added while a job runs, so a full sweep over empty deques means the worker is done
+	void drain( uint32_t worker )
+	{
+		uint32_t threadCount = getThreadCount();
+		Range range;
+		while( true )
+		{
+			bool found = pop( worker , true , range );
+			for( uint32_t i = 1; !found && i < threadCount; i++ )
+			{
+				found = pop( ( worker + i ) % threadCount , false , range );
+				steals += found;
+			}
+			if( !found )
+			{
+				return;
+			}
+			task( worker , range.begin , range.end );
+		}
+	}
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <utility>
+// Bump allocator over a list of malloc'ed slabs. Nothing is freed individually,
+// reset() releases every slab at once.
+struct Arena
+{
+	struct Slab
+	{
+		uint8_t *pData;
+		size_t size;
+		size_t used;
+	};
+	std::vector< Slab > aSlabs;
+	size_t slabSize = 1 << 20;
+	Arena() = default;
+	Arena( Arena const & ) = delete;
+	Arena &operator=( Arena const & ) = delete;
+	Arena( Arena &&arena ) :
+		aSlabs( std::move( arena.aSlabs ) ) ,
+		slabSize( arena.slabSize )
+	{
+		arena.aSlabs.clear();
+	}
+	Arena &operator=( Arena &&arena )
+	{
+		reset();
+		aSlabs.swap( arena.aSlabs );
+		slabSize = arena.slabSize;
+		return *this;
+	}
+	~Arena()
+	{
+		reset();
+	}
+	static size_t alignUp( uintptr_t ptr , size_t align )
+	{
+		return ( ptr + align - 1 ) & ~uintptr_t( align - 1 );
+	}
+	void addSlab( size_t size )
+	{
+		aSlabs.push_back( { ( uint8_t* )malloc( size ) , size , 0 } );
+	}
+	// Makes sure the next allocations totalling bytes fit in one slab
+	void reserve( size_t bytes )
+	{
+		if( aSlabs.empty() || aSlabs.back().size - aSlabs.back().used < bytes )
+		{
+			addSlab( bytes );
+		}
+	}
+	void *allocate( size_t size , size_t align = 16 )
+	{
+		if( !aSlabs.empty() )
+		{
+			Slab &slab = aSlabs.back();
+			uintptr_t base = uintptr_t( slab.pData );
+			size_t offset = alignUp( base + slab.used , align ) - base;
+			if( offset + size <= slab.size )
+			{
+				slab.used = offset + size;
+				return slab.pData + offset;
+			}
+		}
+		addSlab( size + align > slabSize ? size + align : slabSize );
+		return allocate( size , align );
+	}
+	void reset()
+	{
+		for( auto &slab : aSlabs )
+		{
+			free( slab.pData );
+		}
+		aSlabs.clear();
+	}
+	size_t getBytesUsed() const
+	{
+		size_t bytes = 0;
+		for( auto const &slab : aSlabs )
+		{
+			bytes += slab.used;
+		}
+		return bytes;
+	}
+	size_t getBytesReserved() const
+	{
+		size_t bytes = 0;
+		for( auto const &slab : aSlabs )
+		{
+			bytes += slab.size;
+		}
+		return bytes;
+	}
+};
+// Fixed size array of trivially copyable elements living in an Arena
+template< typename T >
+struct ArenaArray
+{
+	T *pData = nullptr;
+	uint32_t count = 0;
+	void allocate( Arena &arena , uint32_t count , size_t align = 16 )
+	{
+		pData = ( T* )arena.allocate( sizeof( T ) * count , align < alignof( T ) ? alignof( T ) : align );
+		this->count = count;
+	}
+	void fill( T const &value )
+	{
+		for( uint32_t i = 0; i < count; i++ )
+		{
+			pData[ i ] = value;
+		}
+	}
+	void reset()
+	{
+		pData = nullptr;
+		count = 0;
+	}
+	uint32_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	size_t getBytes() const
+	{
+		return sizeof( T ) * count;
+	}
+	T &operator[]( uint32_t i )
+	{
+		return pData[ i ];
+	}
+	T const &operator[]( uint32_t i ) const
+	{
+		return pData[ i ];
+	}
+	T *begin()
+	{
+		return pData;
+	}
+	T *end()
+	{
+		return pData + count;
+	}
+	T const *begin() const
+	{
+		return pData;
+	}
+	T const *end() const
+	{
+		return pData + count;
+	}
+};
@@ -0,0 +1,285 @@
+#pragma once
+#include "math/vec.hpp"
+#include "mesh/Arena.hpp"
+#include <stdint.h>
+#include <vector>
+using namespace Math;
+// Triangle half-edge mesh stored as flat index arrays.
+// Half-edge h belongs to face h / 3, its origin is aHalfEdgeOrigin[ h ] and it ends at the origin of aHalfEdgeNext[ h ].
+// Per-element arrays are carved out of one arena per element type, so teardown is a handful of frees.
+struct MeshMemoryStats
+{
+	size_t vertexBytes;
+	size_t halfEdgeBytes;
+	size_t faceBytes;
+	size_t reservedBytes;
+};
+// Geometry of one face packed into a single record for ray and point queries, so they read one
+// cache line or two instead of chasing half-edges into the position array
+struct FaceRecord
+{
+	// Corners in getFaceVertices order
+	float3 p0 , p1 , p2;
+	// p1 - p0 , p2 - p0
+	float3 e1 , e2;
+	// Unit normal along e1 ^ e2, zero for a degenerate face
+	float3 normal;
+	// 1 / area, 0 for a degenerate face
+	float invArea;
+};
+struct Mesh
+{
+	enum : uint32_t { INVALID = 0xffffffffu };
+	// Bumped on every rebuild and geometry change so derived structures know when to refresh
+	uint32_t version = 0;
+	Arena vertexArena;
+	Arena halfEdgeArena;
+	Arena faceArena;
+	ArenaArray< float3 > aPositions;
+	ArenaArray< uint32_t > aHalfEdgeOrigin;
+	ArenaArray< uint32_t > aHalfEdgeTwin;
+	ArenaArray< uint32_t > aHalfEdgeNext;
+	ArenaArray< uint32_t > aHalfEdgeFace;
+	ArenaArray< uint32_t > aFaceHalfEdge;
+	// Filled by updateFaceRecords() once positions and connectivity are final
+	ArenaArray< FaceRecord > aFaceRecords;
+	Mesh() = default;
+	Mesh( Mesh const & ) = delete;
+	Mesh &operator=( Mesh const & ) = delete;
+	Mesh( Mesh && ) = default;
+	Mesh &operator=( Mesh && ) = default;
+	uint32_t getVertexCount() const
+	{
+		return uint32_t( aPositions.size() );
+	}
+	uint32_t getHalfEdgeCount() const
+	{
+		return uint32_t( aHalfEdgeOrigin.size() );
+	}
+	uint32_t getFaceCount() const
+	{
+		return uint32_t( aFaceHalfEdge.size() );
+	}
+	uint32_t getEnd( uint32_t hedge ) const
+	{
+		return aHalfEdgeOrigin[ aHalfEdgeNext[ hedge ] ];
+	}
+	float3 const &getOrigin( uint32_t hedge ) const
+	{
+		return aPositions[ aHalfEdgeOrigin[ hedge ] ];
+	}
+	uint32_t getAdjacentFace( uint32_t hedge ) const
+	{
+		uint32_t twin = aHalfEdgeTwin[ hedge ];
+		return twin == INVALID ? INVALID : aHalfEdgeFace[ twin ];
+	}
+	float3 getEdgeCenter( uint32_t hedge ) const
+	{
+		return ( getOrigin( hedge ) + aPositions[ getEnd( hedge ) ] ) / 2;
+	}
+	float3 getEdgeNormal( uint32_t hedge ) const
+	{
+		return ( aPositions[ getEnd( hedge ) ] - getOrigin( hedge ) ).norm();
+	}
+	float getEdgeLength( uint32_t hedge ) const
+	{
+		return ( aPositions[ getEnd( hedge ) ] - getOrigin( hedge ) ).mod();
+	}
+	// Corners in the order aFaceHalfEdge[ face ] , next , next of next
+	void getFaceVertices( uint32_t face , float3 &p0 , float3 &p1 , float3 &p2 ) const
+	{
+		FaceRecord const &record = aFaceRecords[ face ];
+		p0 = record.p0;
+		p1 = record.p1;
+		p2 = record.p2;
+	}
+	float3 getFaceCenter( uint32_t face ) const
+	{
+		FaceRecord const &record = aFaceRecords[ face ];
+		return ( record.p0 + record.p1 + record.p2 ) / 3.0f;
+	}
+	float getFaceArea( uint32_t face ) const
+	{
+		float invArea = aFaceRecords[ face ].invArea;
+		return invArea > 0.0f ? 1.0f / invArea : 0.0f;
+	}
+	// Barycentric weights of a point on face, in the order of getFaceVertices
+	void getBarycentric( uint32_t face , float3 const &point , float aWeights[ 3 ] ) const
+	{
+		FaceRecord const &record = aFaceRecords[ face ];
+		// Twice the signed area of a sub-triangle over twice the face area
+		float scale = record.invArea * 0.5f;
+		aWeights[ 0 ] = scale > 0.0f ? ( ( record.p1 - point ) ^ ( record.p2 - point ) ) * record.normal * scale : 1.0f / 3.0f;
+		aWeights[ 1 ] = scale > 0.0f ? ( ( record.p2 - point ) ^ ( record.p0 - point ) ) * record.normal * scale : 1.0f / 3.0f;
+		aWeights[ 2 ] = 1.0f - aWeights[ 0 ] - aWeights[ 1 ];
+	}
+	// Closest point to point on the triangle p0 , p0 + e1 , p0 + e2 by its Voronoi regions, with its
+	// barycentric weights in corner order
+	static float3 getClosestPoint( float3 const &p0 , float3 const &e1 , float3 const &e2 , float3 const &point , float aWeights[ 3 ] )
+	{
+		float3 ap = point - p0;
+		float d1 = e1 * ap;
+		float d2 = e2 * ap;
+		float v , w;
+		if( d1 <= 0.0f && d2 <= 0.0f )
+		{
+			v = 0.0f;
+			w = 0.0f;
+		} else
+		{
+			float3 bp = ap - e1;
+			float d3 = e1 * bp;
+			float d4 = e2 * bp;
+			float3 cp = ap - e2;
+			float d5 = e1 * cp;
+			float d6 = e2 * cp;
+			float vc = d1 * d4 - d3 * d2;
+			float vb = d5 * d2 - d1 * d6;
+			float va = d3 * d6 - d5 * d4;
+			if( d3 >= 0.0f && d4 <= d3 )
+			{
+				v = 1.0f;
+				w = 0.0f;
+			} else if( vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f )
+			{
+				v = d1 / ( d1 - d3 );
+				w = 0.0f;
+			} else if( d6 >= 0.0f && d5 <= d6 )
+			{
+				v = 0.0f;
+				w = 1.0f;
+			} else if( vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f )
+			{
+				v = 0.0f;
+				w = d2 / ( d2 - d6 );
+			} else if( va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f )
+			{
+				w = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );
+				v = 1.0f - w;
+			} else if( va + vb + vc > 0.0f )
+			{
+				v = vb / ( va + vb + vc );
+				w = vc / ( va + vb + vc );
+			} else
+			{
+				// Collinear corners, only reached by a degenerate face
+				v = 0.0f;
+				w = 0.0f;
+			}
+		}
+		aWeights[ 0 ] = 1.0f - v - w;
+		aWeights[ 1 ] = v;
+		aWeights[ 2 ] = w;
+		return p0 + e1 * v + e2 * w;
+	}
+	float3 getClosestPoint( uint32_t face , float3 const &point , float aWeights[ 3 ] ) const
+	{
+		FaceRecord const &record = aFaceRecords[ face ];
+		return getClosestPoint( record.p0 , record.e1 , record.e2 , point , aWeights );
+	}
+	// Half-edge of face shared with adjFace or INVALID
+	uint32_t getSharedHalfEdge( uint32_t face , uint32_t adjFace ) const
+	{
+		uint32_t hedge = aFaceHalfEdge[ face ];
+		ito( 3 )
+		{
+			if( getAdjacentFace( hedge ) == adjFace )
+			{
+				return hedge;
+			}
+			hedge = aHalfEdgeNext[ hedge ];
+		}
+		return INVALID;
+	}
+	// Möller-Trumbore, hits both sides of the face at pos + v * t with t >= 0. Degenerate faces
+	// have a zero determinant and are never hit. TriangleBlock runs the same test on eight faces.
+	bool collide( uint32_t face , float3 const &pos , float3 const &v , float3 &proj ) const
+	{
+		FaceRecord const &record = aFaceRecords[ face ];
+		float3 p = v ^ record.e2;
+		float det = record.e1 * p;
+		if( det == 0.0f )
+		{
+			return false;
+		}
+		float invDet = 1.0f / det;
+		float3 s = pos - record.p0;
+		float u = s * p * invDet;
+		if( u < 0.0f || u > 1.0f )
+		{
+			return false;
+		}
+		float3 q = s ^ record.e1;
+		float w = v * q * invDet;
+		float t = record.e2 * q * invDet;
+		if( w < 0.0f || u + w > 1.0f || t < 0.0f )
+		{
+			return false;
+		}
+		proj = pos + v * t;
+		return true;
+	}
+	// Rebuilds every face record from the positions, after the mesh is built or a vertex has moved.
+	// Bumps version so the BVH, dual graph weights, landmarks and heat factors rebuild too.
+	void updateFaceRecords()
+	{
+		version++;
+		int faceCount = int( getFaceCount() );
+#pragma omp parallel for
+		for( int face = 0; face < faceCount; face++ )
+		{
+			uint32_t h0 = aFaceHalfEdge[ face ];
+			uint32_t h1 = aHalfEdgeNext[ h0 ];
+			uint32_t h2 = aHalfEdgeNext[ h1 ];
+			FaceRecord &record = aFaceRecords[ face ];
+			record.p0 = getOrigin( h0 );
+			record.p1 = getOrigin( h1 );
+			record.p2 = getOrigin( h2 );
+			record.e1 = record.p1 - record.p0;
+			record.e2 = record.p2 - record.p0;
+			float3 cross = record.e1 ^ record.e2;
+			float doubleArea = cross.mod();
+			record.normal = doubleArea > 0.0f ? cross / doubleArea : float3( 0.0f );
+			record.invArea = doubleArea > 0.0f ? 2.0f / doubleArea : 0.0f;
+		}
+	}
+	void clear()
+	{
+		aPositions.reset();
+		aHalfEdgeOrigin.reset();
+		aHalfEdgeTwin.reset();
+		aHalfEdgeNext.reset();
+		aHalfEdgeFace.reset();
+		aFaceHalfEdge.reset();
+		aFaceRecords.reset();
+		vertexArena.reset();
+		halfEdgeArena.reset();
+		faceArena.reset();
+	}
+	// Drops the old mesh and sizes every element array in a single slab per arena
+	void allocate( uint32_t vertexCount , uint32_t faceCount )
+	{
+		clear();
+		version++;
+		uint32_t hedgeCount = faceCount * 3;
+		vertexArena.reserve( sizeof( float3 ) * vertexCount + 64 );
+		halfEdgeArena.reserve( sizeof( uint32_t ) * hedgeCount * 4 + 64 * 4 );
+		faceArena.reserve( ( sizeof( uint32_t ) + sizeof( FaceRecord ) ) * faceCount + 64 * 2 );
+		aPositions.allocate( vertexArena , vertexCount );
+		aHalfEdgeOrigin.allocate( halfEdgeArena , hedgeCount );
+		aHalfEdgeTwin.allocate( halfEdgeArena , hedgeCount );
+		aHalfEdgeNext.allocate( halfEdgeArena , hedgeCount );
+		aHalfEdgeFace.allocate( halfEdgeArena , hedgeCount );
+		aFaceHalfEdge.allocate( faceArena , faceCount );
+		aFaceRecords.allocate( faceArena , faceCount );
+	}
+	MeshMemoryStats getMemoryStats() const
+	{
+		return{
+			vertexArena.getBytesUsed() ,
+			halfEdgeArena.getBytesUsed() ,
+			faceArena.getBytesUsed() ,
+			vertexArena.getBytesReserved() + halfEdgeArena.getBytesReserved() + faceArena.getBytesReserved()
+		};
+	}
+};
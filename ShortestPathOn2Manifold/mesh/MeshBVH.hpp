@@ -0,0 +1,553 @@
+#pragma once
+#include "mesh/TriangleBlock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+struct MeshBVHStats
+{
+	uint32_t nodeCount = 0;
+	uint32_t leafCount = 0;
+	uint32_t maxDepth = 0;
+	double seconds = 0.0;
+};
+// Closest surface point to a query point
+struct ClosestPoint
+{
+	uint32_t face = Mesh::INVALID;
+	// Barycentric weights in getFaceVertices order
+	float aWeights[ 3 ];
+	float3 point;
+	float distance = FLT_MAX;
+};
+// Bounding volume hierarchy over the faces, split by binned SAH and stored as a flat node array.
+// The two children of an inner node are adjacent, a leaf owns a run of triangle blocks that the
+// SIMD kernel tests eight faces at a time.
+struct MeshBVH
+{
+	struct Node
+	{
+		float3 boxMin;
+		// Left child of an inner node, first entry in aBlocks of a leaf
+		uint32_t first;
+		float3 boxMax;
+		// Faces of a leaf, 0 for an inner node
+		uint32_t count;
+	};
+	enum : uint32_t
+	{
+		BIN_COUNT = 16 ,
+		MAX_LEAF_SIZE = 8 ,
+		// Deeper nodes become leaves whatever their size, bounds the traversal stack
+		MAX_DEPTH = 64 ,
+		// Consecutive rays of pickRays traversed together, one bit each in the active ray masks
+		PACKET_SIZE = 64
+	};
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	std::vector< Node > aNodes;
+	std::vector< TriangleBlock > aBlocks;
+	MeshBVHStats stats;
+	bool isValid( Mesh const &mesh ) const
+	{
+		return pMesh == &mesh && meshVersion == mesh.version;
+	}
+	// Rebuilds only if the mesh has been reloaded since the last build
+	void update( Mesh const &mesh )
+	{
+		if( !isValid( mesh ) )
+		{
+			build( mesh );
+		}
+	}
+	static float3 minimum( float3 const &a , float3 const &b )
+	{
+		return float3( std::min( a.x , b.x ) , std::min( a.y , b.y ) , std::min( a.z , b.z ) );
+	}
+	static float3 maximum( float3 const &a , float3 const &b )
+	{
+		return float3( std::max( a.x , b.x ) , std::max( a.y , b.y ) , std::max( a.z , b.z ) );
+	}
+	static float getHalfArea( float3 const &boxMin , float3 const &boxMax )
+	{
+		float3 size = boxMax - boxMin;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+	struct Bin
+	{
+		float3 boxMin = float3( FLT_MAX , FLT_MAX , FLT_MAX );
+		float3 boxMax = float3( -FLT_MAX , -FLT_MAX , -FLT_MAX );
+		uint32_t count = 0;
+		void grow( float3 const &pointMin , float3 const &pointMax )
+		{
+			boxMin = minimum( boxMin , pointMin );
+			boxMax = maximum( boxMax , pointMax );
+		}
+	};
+	void build( Mesh const &mesh )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		stats = MeshBVHStats();
+		int faceCount = int( mesh.getFaceCount() );
+		// Face bounds are partitioned in place so every pass streams through memory
+		struct Reference
+		{
+			float3 boxMin;
+			uint32_t face;
+			float3 boxMax;
+			float3 getCenter() const
+			{
+				return ( boxMin + boxMax ) * 0.5f;
+			}
+		};
+		std::vector< Reference > aReferences( faceCount );
+#pragma omp parallel for
+		for( int face = 0; face < faceCount; face++ )
+		{
+			float3 p0 , p1 , p2;
+			mesh.getFaceVertices( face , p0 , p1 , p2 );
+			aReferences[ face ] = { minimum( p0 , minimum( p1 , p2 ) ) , uint32_t( face ) , maximum( p0 , maximum( p1 , p2 ) ) };
+		}
+		aNodes.clear();
+		// A binary tree over faceCount leaves or fewer
+		aNodes.reserve( faceCount > 0 ? 2 * faceCount - 1 : 1 );
+		aNodes.push_back( Node() );
+		struct Task
+		{
+			uint32_t node , begin , end , depth;
+		};
+		std::vector< Task > stack;
+		stack.push_back( { 0 , 0 , uint32_t( faceCount ) , 1 } );
+		while( !stack.empty() )
+		{
+			Task task = stack.back();
+			stack.pop_back();
+			stats.maxDepth = std::max( stats.maxDepth , task.depth );
+			uint32_t count = task.end - task.begin;
+			Bin bounds , centroidBounds;
+			for( uint32_t i = task.begin; i < task.end; i++ )
+			{
+				Reference const &reference = aReferences[ i ];
+				float3 center = reference.getCenter();
+				bounds.grow( reference.boxMin , reference.boxMax );
+				centroidBounds.grow( center , center );
+			}
+			Node &node = aNodes[ task.node ];
+			node.boxMin = bounds.boxMin;
+			node.boxMax = bounds.boxMax;
+			node.first = task.begin;
+			node.count = count;
+			// Binned SAH over the centroid extent of each axis. A leaf costs one kernel call per started
+			// block, a traversal step as much as a block.
+			float bestCost = FLT_MAX;
+			int bestAxis = -1;
+			uint32_t bestBin = 0;
+			float3 extent = centroidBounds.boxMax - centroidBounds.boxMin;
+			float3 scale;
+			ito( 3 )
+			{
+				scale[ i ] = extent[ i ] > 0.0f ? BIN_COUNT / extent[ i ] : 0.0f;
+			}
+			// One pass bins every axis
+			Bin aBins[ 3 ][ BIN_COUNT ];
+			for( uint32_t i = task.begin; i < task.end && count > 1; i++ )
+			{
+				Reference const &reference = aReferences[ i ];
+				float3 binPos = ( reference.getCenter() - centroidBounds.boxMin ) & scale;
+				for( int axis = 0; axis < 3; axis++ )
+				{
+					Bin &bin = aBins[ axis ][ std::min( uint32_t( BIN_COUNT - 1 ) , uint32_t( binPos[ axis ] ) ) ];
+					bin.count++;
+					bin.grow( reference.boxMin , reference.boxMax );
+				}
+			}
+			for( int axis = 0; axis < 3 && count > 1; axis++ )
+			{
+				if( extent[ axis ] <= 0.0f )
+				{
+					continue;
+				}
+				// Right sweep first, then the left sweep evaluates every plane
+				float aRightArea[ BIN_COUNT ];
+				uint32_t aRightCount[ BIN_COUNT ];
+				Bin right;
+				for( int bin = BIN_COUNT - 1; bin > 0; bin-- )
+				{
+					right.grow( aBins[ axis ][ bin ].boxMin , aBins[ axis ][ bin ].boxMax );
+					right.count += aBins[ axis ][ bin ].count;
+					aRightArea[ bin ] = right.count ? getHalfArea( right.boxMin , right.boxMax ) : 0.0f;
+					aRightCount[ bin ] = right.count;
+				}
+				Bin left;
+				for( uint32_t bin = 0; bin + 1 < BIN_COUNT; bin++ )
+				{
+					left.grow( aBins[ axis ][ bin ].boxMin , aBins[ axis ][ bin ].boxMax );
+					left.count += aBins[ axis ][ bin ].count;
+					if( left.count == 0 || aRightCount[ bin + 1 ] == 0 )
+					{
+						continue;
+					}
+					float cost = TriangleBlock::getBlockCount( left.count ) * getHalfArea( left.boxMin , left.boxMax ) +
+						TriangleBlock::getBlockCount( aRightCount[ bin + 1 ] ) * aRightArea[ bin + 1 ];
+					if( cost < bestCost )
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+			float leafCost = float( TriangleBlock::getBlockCount( count ) );
+			float splitCost = 1.0f + bestCost / getHalfArea( bounds.boxMin , bounds.boxMax );
+			if( bestAxis < 0 || ( count <= MAX_LEAF_SIZE && splitCost >= leafCost ) || task.depth >= MAX_DEPTH )
+			{
+				// Faces with coincident centroids cannot be binned apart, split them by index instead
+				if( count <= MAX_LEAF_SIZE || task.depth >= MAX_DEPTH )
+				{
+					stats.leafCount++;
+					continue;
+				}
+				bestAxis = -1;
+			}
+			uint32_t middle;
+			if( bestAxis < 0 )
+			{
+				middle = task.begin + count / 2;
+			} else
+			{
+				float axisScale = scale[ bestAxis ];
+				float axisMin = centroidBounds.boxMin[ bestAxis ];
+				middle = uint32_t( std::partition( aReferences.begin() + task.begin , aReferences.begin() + task.end ,
+					[ & ]( Reference const &reference )
+					{
+						return std::min( uint32_t( BIN_COUNT - 1 ) , uint32_t( ( reference.getCenter()[ bestAxis ] - axisMin ) * axisScale ) ) <= bestBin;
+					} ) - aReferences.begin() );
+			}
+			uint32_t left = uint32_t( aNodes.size() );
+			aNodes[ task.node ].first = left;
+			aNodes[ task.node ].count = 0;
+			aNodes.push_back( Node() );
+			aNodes.push_back( Node() );
+			stack.push_back( { left + 1 , middle , task.end , task.depth + 1 } );
+			stack.push_back( { left , task.begin , middle , task.depth + 1 } );
+		}
+		// Leaves are packed in node order, each into its own blocks
+		std::vector< uint32_t > aFaceOrder( faceCount );
+		for( int i = 0; i < faceCount; i++ )
+		{
+			aFaceOrder[ i ] = aReferences[ i ].face;
+		}
+		std::vector< uint32_t > aLeaves;
+		uint32_t blockCount = 0;
+		for( uint32_t i = 0; i < aNodes.size(); i++ )
+		{
+			if( aNodes[ i ].count )
+			{
+				aLeaves.push_back( i );
+				aLeaves.push_back( blockCount );
+				blockCount += TriangleBlock::getBlockCount( aNodes[ i ].count );
+			}
+		}
+		aBlocks.resize( blockCount );
+		int leafCount = int( aLeaves.size() / 2 );
+#pragma omp parallel for
+		for( int leaf = 0; leaf < leafCount; leaf++ )
+		{
+			Node &node = aNodes[ aLeaves[ leaf * 2 ] ];
+			TriangleBlock::pack( mesh , &aFaceOrder[ node.first ] , node.count , &aBlocks[ aLeaves[ leaf * 2 + 1 ] ] );
+			node.first = aLeaves[ leaf * 2 + 1 ];
+		}
+		stats.nodeCount = uint32_t( aNodes.size() );
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+	}
+	// Entry distance of the ray into the box, FLT_MAX if it misses or enters beyond maxT
+	static float intersectBox( Node const &node , float3 const &pos , float3 const &invDir , float maxT )
+	{
+		float3 t0 = ( node.boxMin - pos ) & invDir;
+		float3 t1 = ( node.boxMax - pos ) & invDir;
+		float tNear = std::max( std::max( std::min( t0.x , t1.x ) , std::min( t0.y , t1.y ) ) , std::max( std::min( t0.z , t1.z ) , 0.0f ) );
+		float tFar = std::min( std::min( std::max( t0.x , t1.x ) , std::max( t0.y , t1.y ) ) , std::min( std::max( t0.z , t1.z ) , maxT ) );
+		return tNear <= tFar ? tNear : FLT_MAX;
+	}
+	// Squared distance from point to the box, 0 inside it
+	static float getBoxDistance2( Node const &node , float3 const &point )
+	{
+		float3 below = maximum( node.boxMin - point , float3( 0.0f ) );
+		float3 above = maximum( point - node.boxMax , float3( 0.0f ) );
+		return below * below + above * above;
+	}
+	// Closest point on the surface no farther than maxDistance. Boxes farther than the best face so
+	// far are pruned and the nearer child is visited first, so the bound tightens quickly.
+	// Returns false if no face is within maxDistance.
+	bool closestPoint( float3 const &point , ClosestPoint &result , float maxDistance = FLT_MAX ) const
+	{
+		result = ClosestPoint();
+		if( aNodes.empty() || aBlocks.empty() )
+		{
+			return false;
+		}
+		float bestDist2 = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+		uint32_t stack[ MAX_DEPTH ];
+		uint32_t stackSize = 0;
+		if( getBoxDistance2( aNodes[ 0 ] , point ) > bestDist2 )
+		{
+			return false;
+		}
+		stack[ stackSize++ ] = 0;
+		while( stackSize )
+		{
+			Node const &node = aNodes[ stack[ --stackSize ] ];
+			if( getBoxDistance2( node , point ) > bestDist2 )
+			{
+				continue;
+			}
+			if( node.count )
+			{
+				uint32_t end = node.first + TriangleBlock::getBlockCount( node.count );
+				for( uint32_t i = node.first; i < end; i++ )
+				{
+					TriangleBlock const &block = aBlocks[ i ];
+					for( uint32_t lane = 0; lane < TriangleBlock::WIDTH && block.aFaces[ lane ] != Mesh::INVALID; lane++ )
+					{
+						float3 p0( block.aP0[ 0 ][ lane ] , block.aP0[ 1 ][ lane ] , block.aP0[ 2 ][ lane ] );
+						float3 e1( block.aE1[ 0 ][ lane ] , block.aE1[ 1 ][ lane ] , block.aE1[ 2 ][ lane ] );
+						float3 e2( block.aE2[ 0 ][ lane ] , block.aE2[ 1 ][ lane ] , block.aE2[ 2 ][ lane ] );
+						float aWeights[ 3 ];
+						float3 closest = Mesh::getClosestPoint( p0 , e1 , e2 , point , aWeights );
+						float dist2 = closest.dist2( point );
+						if( dist2 <= bestDist2 )
+						{
+							bestDist2 = dist2;
+							result.face = block.aFaces[ lane ];
+							result.point = closest;
+							result.aWeights[ 0 ] = aWeights[ 0 ];
+							result.aWeights[ 1 ] = aWeights[ 1 ];
+							result.aWeights[ 2 ] = aWeights[ 2 ];
+						}
+					}
+				}
+				continue;
+			}
+			float dLeft = getBoxDistance2( aNodes[ node.first ] , point );
+			float dRight = getBoxDistance2( aNodes[ node.first + 1 ] , point );
+			uint32_t nearChild = dLeft <= dRight ? node.first : node.first + 1;
+			uint32_t farChild = dLeft <= dRight ? node.first + 1 : node.first;
+			if( std::max( dLeft , dRight ) <= bestDist2 )
+			{
+				stack[ stackSize++ ] = farChild;
+			}
+			if( std::min( dLeft , dRight ) <= bestDist2 )
+			{
+				stack[ stackSize++ ] = nearChild;
+			}
+		}
+		if( result.face == Mesh::INVALID )
+		{
+			return false;
+		}
+		result.distance = sqrtf( bestDist2 );
+		return true;
+	}
+	// closestPoint for every point in parallel, results in input order
+	void closestPoints( std::vector< float3 > const &aPoints , std::vector< ClosestPoint > &aResults , float maxDistance = FLT_MAX ) const
+	{
+		int count = int( aPoints.size() );
+		aResults.resize( count );
+#pragma omp parallel for schedule( dynamic , 1024 )
+		for( int i = 0; i < count; i++ )
+		{
+			closestPoint( aPoints[ i ] , aResults[ i ] , maxDistance );
+		}
+	}
+	// Closest face hit by the ray pos + dir * t, t >= 0. Returns false if nothing is hit.
+	bool pick( float3 const &pos , float3 const &dir , uint32_t &hitFace , float3 &hitPoint ) const
+	{
+		hitFace = Mesh::INVALID;
+		if( aNodes.empty() || aBlocks.empty() )
+		{
+			return false;
+		}
+		float3 invDir( 1.0f / dir.x , 1.0f / dir.y , 1.0f / dir.z );
+		float bestT = FLT_MAX , u , v;
+		uint32_t stack[ MAX_DEPTH ];
+		uint32_t stackSize = 0;
+		if( intersectBox( aNodes[ 0 ] , pos , invDir , bestT ) == FLT_MAX )
+		{
+			return false;
+		}
+		stack[ stackSize++ ] = 0;
+		while( stackSize )
+		{
+			Node const &node = aNodes[ stack[ --stackSize ] ];
+			if( intersectBox( node , pos , invDir , bestT ) == FLT_MAX )
+			{
+				continue;
+			}
+			if( node.count )
+			{
+				uint32_t end = node.first + TriangleBlock::getBlockCount( node.count );
+				for( uint32_t block = node.first; block < end; block++ )
+				{
+					uint32_t lane = aBlocks[ block ].intersect( pos , dir , bestT , u , v );
+					if( lane != TriangleBlock::NONE )
+					{
+						hitFace = aBlocks[ block ].aFaces[ lane ];
+					}
+				}
+				continue;
+			}
+			// Nearer child on top of the stack
+			float tLeft = intersectBox( aNodes[ node.first ] , pos , invDir , bestT );
+			float tRight = intersectBox( aNodes[ node.first + 1 ] , pos , invDir , bestT );
+			uint32_t nearChild = tLeft <= tRight ? node.first : node.first + 1;
+			uint32_t farChild = tLeft <= tRight ? node.first + 1 : node.first;
+			if( std::max( tLeft , tRight ) != FLT_MAX )
+			{
+				stack[ stackSize++ ] = farChild;
+			}
+			if( std::min( tLeft , tRight ) != FLT_MAX )
+			{
+				stack[ stackSize++ ] = nearChild;
+			}
+		}
+		if( hitFace != Mesh::INVALID )
+		{
+			hitPoint = pos + dir * bestT;
+		}
+		return hitFace != Mesh::INVALID;
+	}
+	// Conservative test of a packet of rays leaving pos against the box, by interval arithmetic on
+	// the inverse directions invDirMin..invDirMax of each axis. An axis whose rays point both ways
+	// does not bound anything. False only if no ray of the packet can enter the box before maxT.
+	static bool intersectBoxPacket( Node const &node , float3 const &pos , float3 const &invDirMin , float3 const &invDirMax , float maxT )
+	{
+		float tNear = 0.0f , tFar = maxT;
+		ito( 3 )
+		{
+			float nearPlane , farPlane;
+			if( invDirMin[ i ] >= 0.0f )
+			{
+				nearPlane = node.boxMin[ i ] - pos[ i ];
+				farPlane = node.boxMax[ i ] - pos[ i ];
+			} else if( invDirMax[ i ] <= 0.0f )
+			{
+				nearPlane = node.boxMax[ i ] - pos[ i ];
+				farPlane = node.boxMin[ i ] - pos[ i ];
+			} else
+			{
+				continue;
+			}
+			tNear = std::max( tNear , std::min( nearPlane * invDirMin[ i ] , nearPlane * invDirMax[ i ] ) );
+			tFar = std::min( tFar , std::max( farPlane * invDirMin[ i ] , farPlane * invDirMax[ i ] ) );
+		}
+		return tNear <= tFar;
+	}
+	// Up to PACKET_SIZE rays sharing the origin pos traversed together. A node is culled for the whole
+	// packet by intersectBoxPacket first, then each ray still active in the parent is tested against
+	// its box and the children only carry the rays that enter it.
+	void pickPacket( float3 const &pos , float3 const *aDirs , uint32_t rayCount , uint32_t *aHitFaces , float3 *aHitPoints ) const
+	{
+		float3 aInvDir[ PACKET_SIZE ];
+		float aBestT[ PACKET_SIZE ];
+		float3 invDirMin( FLT_MAX , FLT_MAX , FLT_MAX ) , invDirMax( -FLT_MAX , -FLT_MAX , -FLT_MAX );
+		for( uint32_t i = 0; i < rayCount; i++ )
+		{
+			aInvDir[ i ] = float3( 1.0f / aDirs[ i ].x , 1.0f / aDirs[ i ].y , 1.0f / aDirs[ i ].z );
+			invDirMin = minimum( invDirMin , aInvDir[ i ] );
+			invDirMax = maximum( invDirMax , aInvDir[ i ] );
+			aBestT[ i ] = FLT_MAX;
+			aHitFaces[ i ] = Mesh::INVALID;
+		}
+		// Farthest hit so far, nodes entered beyond it cannot improve any ray
+		float packetMaxT = FLT_MAX;
+		struct Entry
+		{
+			uint32_t node;
+			uint64_t activeRays;
+		};
+		Entry stack[ MAX_DEPTH ];
+		uint32_t stackSize = 0;
+		stack[ stackSize++ ] = { 0 , rayCount == 64 ? ~0ull : ( 1ull << rayCount ) - 1 };
+		while( stackSize )
+		{
+			Entry entry = stack[ --stackSize ];
+			Node const &node = aNodes[ entry.node ];
+			if( !intersectBoxPacket( node , pos , invDirMin , invDirMax , packetMaxT ) )
+			{
+				continue;
+			}
+			uint64_t activeRays = 0;
+			for( uint32_t ray = 0; ray < rayCount; ray++ )
+			{
+				if( ( entry.activeRays >> ray & 1 ) && intersectBox( node , pos , aInvDir[ ray ] , aBestT[ ray ] ) != FLT_MAX )
+				{
+					activeRays |= 1ull << ray;
+				}
+			}
+			if( !activeRays )
+			{
+				continue;
+			}
+			if( node.count )
+			{
+				uint32_t end = node.first + TriangleBlock::getBlockCount( node.count );
+				for( uint32_t ray = 0; ray < rayCount; ray++ )
+				{
+					if( !( activeRays >> ray & 1 ) )
+					{
+						continue;
+					}
+					float u , v;
+					for( uint32_t block = node.first; block < end; block++ )
+					{
+						uint32_t lane = aBlocks[ block ].intersect( pos , aDirs[ ray ] , aBestT[ ray ] , u , v );
+						if( lane != TriangleBlock::NONE )
+						{
+							aHitFaces[ ray ] = aBlocks[ block ].aFaces[ lane ];
+						}
+					}
+				}
+				packetMaxT = 0.0f;
+				for( uint32_t ray = 0; ray < rayCount; ray++ )
+				{
+					packetMaxT = std::max( packetMaxT , aBestT[ ray ] );
+				}
+				continue;
+			}
+			// Shared origin, so the child whose center is nearer to it is nearer for most rays
+			Node const &left = aNodes[ node.first ];
+			Node const &right = aNodes[ node.first + 1 ];
+			bool leftFirst = ( left.boxMin + left.boxMax - pos * 2.0f ).mod2() <= ( right.boxMin + right.boxMax - pos * 2.0f ).mod2();
+			stack[ stackSize++ ] = { leftFirst ? node.first + 1 : node.first , activeRays };
+			stack[ stackSize++ ] = { leftFirst ? node.first : node.first + 1 , activeRays };
+		}
+		for( uint32_t i = 0; i < rayCount; i++ )
+		{
+			if( aHitFaces[ i ] != Mesh::INVALID )
+			{
+				aHitPoints[ i ] = pos + aDirs[ i ] * aBestT[ i ];
+			}
+		}
+	}
+	// Casts rayCount rays pos + aDirs[ i ] * t, e.g. a grid of Camera::getCameraRay directions, in
+	// parallel packets of PACKET_SIZE consecutive rays. Packets are culled by their common bounds, so
+	// order the rays in small tiles rather than long rows. aHitFaces[ i ] is INVALID for a miss.
+	void pickRays( float3 const &pos , float3 const *aDirs , uint32_t rayCount , uint32_t *aHitFaces , float3 *aHitPoints ) const
+	{
+		if( aNodes.empty() || aBlocks.empty() )
+		{
+			std::fill( aHitFaces , aHitFaces + rayCount , uint32_t( Mesh::INVALID ) );
+			return;
+		}
+		int packetCount = int( ( rayCount + PACKET_SIZE - 1 ) / PACKET_SIZE );
+#pragma omp parallel for schedule( dynamic , 4 )
+		for( int packet = 0; packet < packetCount; packet++ )
+		{
+			uint32_t first = uint32_t( packet ) * PACKET_SIZE;
+			uint32_t count = std::min( uint32_t( PACKET_SIZE ) , rayCount - first );
+			pickPacket( pos , aDirs + first , count , aHitFaces + first , aHitPoints + first );
+		}
+	}
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include "tiny_obj_loader.h"
+#include <chrono>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+struct MeshBuildStats
+{
+	double seconds = 0.0;
+	uint32_t edgeCount = 0;
+	uint32_t boundaryEdgeCount = 0;
+	uint32_t nonManifoldEdgeCount = 0;
+	uint32_t nonManifoldVertexCount = 0;
+	uint32_t degenerateFaceCount = 0;
+};
+// Bulk connectivity builder: every half-edge gets a (min,max) vertex key, the keys are radix sorted
+// and twins are the two entries of each run. Runs of one are boundary edges, anything else is rejected.
+// Vertices whose faces form more than one fan (bowties) are rejected too, the half-edge walks around
+// a vertex would only ever see one of the fans.
+struct MeshBuilder
+{
+	static int getChunkCount( int count )
+	{
+#ifdef _OPENMP
+		int threads = omp_get_max_threads();
+#else
+		int threads = 1;
+#endif
+		int chunks = ( count + 0xffff ) >> 16;
+		return chunks < 1 ? 1 : chunks > threads * 4 ? threads * 4 : chunks;
+	}
+	// Stable LSD radix sort of ( key , value ) pairs on the lowest keyBits bits of the key
+	static void radixSort( std::vector< uint64_t > &aKeys , std::vector< uint32_t > &aValues , uint32_t keyBits )
+	{
+		const int DIGIT_BITS = 11;
+		const int BUCKETS = 1 << DIGIT_BITS;
+		int count = int( aKeys.size() );
+		int chunkCount = getChunkCount( count );
+		int chunkSize = ( count + chunkCount - 1 ) / chunkCount;
+		std::vector< uint64_t > aTmpKeys( count );
+		std::vector< uint32_t > aTmpValues( count );
+		std::vector< uint32_t > aHistogram( chunkCount * BUCKETS );
+		for( uint32_t shift = 0; shift < keyBits; shift += DIGIT_BITS )
+		{
+			std::fill( aHistogram.begin() , aHistogram.end() , 0u );
+#pragma omp parallel for
+			for( int chunk = 0; chunk < chunkCount; chunk++ )
+			{
+				uint32_t *pHistogram = &aHistogram[ chunk * BUCKETS ];
+				int end = chunk * chunkSize + chunkSize < count ? chunk * chunkSize + chunkSize : count;
+				for( int i = chunk * chunkSize; i < end; i++ )
+				{
+					pHistogram[ ( aKeys[ i ] >> shift ) & ( BUCKETS - 1 ) ]++;
+				}
+			}
+			uint32_t offset = 0;
+			for( int digit = 0; digit < BUCKETS; digit++ )
+			{
+				for( int chunk = 0; chunk < chunkCount; chunk++ )
+				{
+					uint32_t bucketCount = aHistogram[ chunk * BUCKETS + digit ];
+					aHistogram[ chunk * BUCKETS + digit ] = offset;
+					offset += bucketCount;
+				}
+			}
+#pragma omp parallel for
+			for( int chunk = 0; chunk < chunkCount; chunk++ )
+			{
+				uint32_t *pHistogram = &aHistogram[ chunk * BUCKETS ];
+				int end = chunk * chunkSize + chunkSize < count ? chunk * chunkSize + chunkSize : count;
+				for( int i = chunk * chunkSize; i < end; i++ )
+				{
+					uint32_t dst = pHistogram[ ( aKeys[ i ] >> shift ) & ( BUCKETS - 1 ) ]++;
+					aTmpKeys[ dst ] = aKeys[ i ];
+					aTmpValues[ dst ] = aValues[ i ];
+				}
+			}
+			aKeys.swap( aTmpKeys );
+			aValues.swap( aTmpValues );
+		}
+	}
+	// vertexPosition( i ) returns the i-th vertex, vertexIndex( i ) the vertex of the i-th corner of the index buffer
+	template< typename P , typename F >
+	static bool build( Mesh &mesh , uint32_t vertexCount , P vertexPosition , uint32_t indexCount , F vertexIndex , MeshBuildStats &stats )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		stats = MeshBuildStats();
+		int faceCount = int( indexCount / 3 );
+		int hedgeCount = faceCount * 3;
+		mesh.allocate( vertexCount , faceCount );
+#pragma omp parallel for
+		for( int i = 0; i < int( vertexCount ); i++ )
+		{
+			mesh.aPositions[ i ] = vertexPosition( i );
+		}
+		mesh.aHalfEdgeTwin.fill( Mesh::INVALID );
+		uint32_t vertexBits = 1;
+		while( vertexBits < 32 && ( 1u << vertexBits ) < vertexCount )
+		{
+			vertexBits++;
+		}
+		std::vector< uint64_t > aKeys( hedgeCount );
+		std::vector< uint32_t > aValues( hedgeCount );
+		// One outgoing half-edge and the outgoing count per vertex, for the fan walk at the end
+		std::vector< uint32_t > aOutCount( vertexCount , 0 );
+		std::vector< uint32_t > aFirstOut( vertexCount , Mesh::INVALID );
+		int degenerateFaceCount = 0;
+#pragma omp parallel for reduction( + : degenerateFaceCount )
+		for( int face = 0; face < faceCount; face++ )
+		{
+			uint32_t aVertices[ 3 ];
+			ito( 3 )
+			{
+				aVertices[ i ] = uint32_t( vertexIndex( face * 3 + i ) );
+			}
+			if( aVertices[ 0 ] >= vertexCount || aVertices[ 1 ] >= vertexCount || aVertices[ 2 ] >= vertexCount
+				|| aVertices[ 0 ] == aVertices[ 1 ] || aVertices[ 1 ] == aVertices[ 2 ] || aVertices[ 2 ] == aVertices[ 0 ] )
+			{
+				degenerateFaceCount++;
+			} else
+			{
+				// Any outgoing half-edge will do as the first, whichever thread writes last
+				ito( 3 )
+				{
+#pragma omp atomic
+					aOutCount[ aVertices[ i ] ]++;
+#pragma omp atomic write
+					aFirstOut[ aVertices[ i ] ] = uint32_t( face * 3 + i );
+				}
+			}
+			mesh.aFaceHalfEdge[ face ] = face * 3;
+			ito( 3 )
+			{
+				uint32_t hedge = face * 3 + i;
+				uint32_t origin = aVertices[ i ];
+				uint32_t end = aVertices[ ( i + 1 ) % 3 ];
+				mesh.aHalfEdgeOrigin[ hedge ] = origin;
+				mesh.aHalfEdgeNext[ hedge ] = face * 3 + ( i + 1 ) % 3;
+				mesh.aHalfEdgeFace[ hedge ] = face;
+				aKeys[ hedge ] = origin < end ?
+					( uint64_t( origin ) << vertexBits ) | end :
+					( uint64_t( end ) << vertexBits ) | origin;
+				aValues[ hedge ] = hedge;
+			}
+		}
+		stats.degenerateFaceCount = degenerateFaceCount;
+		if( degenerateFaceCount )
+		{
+			stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			mesh.clear();
+			return false;
+		}
+		radixSort( aKeys , aValues , vertexBits * 2 );
+		int edgeCount = 0 , boundaryEdgeCount = 0 , nonManifoldEdgeCount = 0;
+#pragma omp parallel for reduction( + : edgeCount , boundaryEdgeCount , nonManifoldEdgeCount )
+		for( int i = 0; i < hedgeCount; i++ )
+		{
+			if( i > 0 && aKeys[ i - 1 ] == aKeys[ i ] )
+			{
+				continue;
+			}
+			int runLength = 1;
+			while( i + runLength < hedgeCount && aKeys[ i + runLength ] == aKeys[ i ] )
+			{
+				runLength++;
+			}
+			edgeCount++;
+			if( runLength == 1 )
+			{
+				boundaryEdgeCount++;
+			} else if( runLength == 2
+				&& mesh.aHalfEdgeOrigin[ aValues[ i ] ] != mesh.aHalfEdgeOrigin[ aValues[ i + 1 ] ] )
+			{
+				mesh.aHalfEdgeTwin[ aValues[ i ] ] = aValues[ i + 1 ];
+				mesh.aHalfEdgeTwin[ aValues[ i + 1 ] ] = aValues[ i ];
+			} else
+			{
+				nonManifoldEdgeCount++;
+			}
+		}
+		stats.edgeCount = edgeCount;
+		stats.boundaryEdgeCount = boundaryEdgeCount;
+		stats.nonManifoldEdgeCount = nonManifoldEdgeCount;
+		if( nonManifoldEdgeCount )
+		{
+			stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			mesh.clear();
+			return false;
+		}
+		// Every fan is walked once
+		int nonManifoldVertexCount = 0;
+#pragma omp parallel for reduction( + : nonManifoldVertexCount )
+		for( int vertex = 0; vertex < int( vertexCount ); vertex++ )
+		{
+			uint32_t first = aFirstOut[ vertex ];
+			if( first == Mesh::INVALID )
+			{
+				continue;
+			}
+			// Back to the start of an open fan, through the twin of the outgoing half-edge
+			uint32_t hedge = first;
+			for( uint32_t step = 0; step < aOutCount[ vertex ]; step++ )
+			{
+				uint32_t twin = mesh.aHalfEdgeTwin[ hedge ];
+				if( twin == Mesh::INVALID || mesh.aHalfEdgeNext[ twin ] == first )
+				{
+					break;
+				}
+				hedge = mesh.aHalfEdgeNext[ twin ];
+			}
+			// Forward through the twin of the incoming half-edge until the fan closes or ends
+			uint32_t fanStart = hedge , fanSize = 0;
+			do
+			{
+				fanSize++;
+				hedge = mesh.aHalfEdgeTwin[ mesh.aHalfEdgeNext[ mesh.aHalfEdgeNext[ hedge ] ] ];
+			} while( hedge != Mesh::INVALID && hedge != fanStart && fanSize <= aOutCount[ vertex ] );
+			if( fanSize != aOutCount[ vertex ] )
+			{
+				nonManifoldVertexCount++;
+			}
+		}
+		stats.nonManifoldVertexCount = nonManifoldVertexCount;
+		if( nonManifoldVertexCount )
+		{
+			stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+			mesh.clear();
+			return false;
+		}
+		mesh.updateFaceRecords();
+		stats.seconds = std::chrono::duration< double >( std::chrono::high_resolution_clock::now() - start ).count();
+		return true;
+	}
+	static bool build( Mesh &mesh , std::vector< float3 > const &positions , std::vector< uint32_t > const &indices , MeshBuildStats &stats )
+	{
+		return build( mesh , uint32_t( positions.size() ) ,
+			[ &positions ]( int i )
+			{
+				return positions[ i ];
+			} , uint32_t( indices.size() ) ,
+			[ &indices ]( int i )
+			{
+				return indices[ i ];
+			} , stats );
+	}
+	static bool build( Mesh &mesh , tinyobj::attrib_t const &attrib , std::vector< tinyobj::index_t > const &indices , MeshBuildStats &stats )
+	{
+		return build( mesh , uint32_t( attrib.vertices.size() / 3 ) ,
+			[ &attrib ]( int i )
+			{
+				return float3( attrib.vertices[ i * 3 ] , attrib.vertices[ i * 3 + 1 ] , attrib.vertices[ i * 3 + 2 ] );
+			} , uint32_t( indices.size() ) ,
+			[ &indices ]( int i )
+			{
+				return indices[ i ].vertex_index;
+			} , stats );
+	}
+};
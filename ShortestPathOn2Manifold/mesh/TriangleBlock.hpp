@@ -0,0 +1,203 @@
+#pragma once
+#include "mesh/Mesh.hpp"
+#include <float.h>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+// Eight triangles in SoA layout, one lane per triangle: first vertex and the two edges leaving it.
+// Unused lanes have zero edges and face INVALID, the kernel sees them as degenerate and never hits.
+struct TriangleBlock
+{
+	enum : uint32_t
+	{
+		WIDTH = 8 ,
+		NONE = 0xffffffffu
+	};
+	float aP0[ 3 ][ WIDTH ];
+	float aE1[ 3 ][ WIDTH ];
+	float aE2[ 3 ][ WIDTH ];
+	uint32_t aFaces[ WIDTH ];
+	void clear()
+	{
+		ito( 3 )
+		{
+			for( uint32_t lane = 0; lane < WIDTH; lane++ )
+			{
+				aP0[ i ][ lane ] = 0.0f;
+				aE1[ i ][ lane ] = 0.0f;
+				aE2[ i ][ lane ] = 0.0f;
+			}
+		}
+		for( uint32_t lane = 0; lane < WIDTH; lane++ )
+		{
+			aFaces[ lane ] = Mesh::INVALID;
+		}
+	}
+	void set( uint32_t lane , uint32_t face , FaceRecord const &record )
+	{
+		ito( 3 )
+		{
+			aP0[ i ][ lane ] = record.p0[ i ];
+			aE1[ i ][ lane ] = record.e1[ i ];
+			aE2[ i ][ lane ] = record.e2[ i ];
+		}
+		aFaces[ lane ] = face;
+	}
+	// Möller-Trumbore on all lanes against the ray pos + dir * t. Returns the lane of the nearest hit
+	// with 0 <= t < maxT and lowers maxT to it, NONE if no lane hits closer. Both sides are hit.
+	uint32_t intersect( float3 const &pos , float3 const &dir , float &maxT , float &u , float &v ) const
+	{
+		float aT[ WIDTH ] , aU[ WIDTH ] , aV[ WIDTH ];
+		uint32_t hitMask = 0;
+#ifdef __AVX2__
+		__m256 dirX = _mm256_set1_ps( dir.x ) , dirY = _mm256_set1_ps( dir.y ) , dirZ = _mm256_set1_ps( dir.z );
+		__m256 e1X = _mm256_loadu_ps( aE1[ 0 ] ) , e1Y = _mm256_loadu_ps( aE1[ 1 ] ) , e1Z = _mm256_loadu_ps( aE1[ 2 ] );
+		__m256 e2X = _mm256_loadu_ps( aE2[ 0 ] ) , e2Y = _mm256_loadu_ps( aE2[ 1 ] ) , e2Z = _mm256_loadu_ps( aE2[ 2 ] );
+		// p = dir x e2 , det = e1 . p
+		__m256 pX = _mm256_sub_ps( _mm256_mul_ps( dirY , e2Z ) , _mm256_mul_ps( dirZ , e2Y ) );
+		__m256 pY = _mm256_sub_ps( _mm256_mul_ps( dirZ , e2X ) , _mm256_mul_ps( dirX , e2Z ) );
+		__m256 pZ = _mm256_sub_ps( _mm256_mul_ps( dirX , e2Y ) , _mm256_mul_ps( dirY , e2X ) );
+		__m256 det = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e1X , pX ) , _mm256_mul_ps( e1Y , pY ) ) , _mm256_mul_ps( e1Z , pZ ) );
+		__m256 invDet = _mm256_div_ps( _mm256_set1_ps( 1.0f ) , det );
+		// s = pos - p0 , u = s . p / det
+		__m256 sX = _mm256_sub_ps( _mm256_set1_ps( pos.x ) , _mm256_loadu_ps( aP0[ 0 ] ) );
+		__m256 sY = _mm256_sub_ps( _mm256_set1_ps( pos.y ) , _mm256_loadu_ps( aP0[ 1 ] ) );
+		__m256 sZ = _mm256_sub_ps( _mm256_set1_ps( pos.z ) , _mm256_loadu_ps( aP0[ 2 ] ) );
+		__m256 laneU = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( sX , pX ) , _mm256_mul_ps( sY , pY ) ) , _mm256_mul_ps( sZ , pZ ) ) , invDet );
+		// q = s x e1 , v = dir . q / det , t = e2 . q / det
+		__m256 qX = _mm256_sub_ps( _mm256_mul_ps( sY , e1Z ) , _mm256_mul_ps( sZ , e1Y ) );
+		__m256 qY = _mm256_sub_ps( _mm256_mul_ps( sZ , e1X ) , _mm256_mul_ps( sX , e1Z ) );
+		__m256 qZ = _mm256_sub_ps( _mm256_mul_ps( sX , e1Y ) , _mm256_mul_ps( sY , e1X ) );
+		__m256 laneV = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dirX , qX ) , _mm256_mul_ps( dirY , qY ) ) , _mm256_mul_ps( dirZ , qZ ) ) , invDet );
+		__m256 laneT = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e2X , qX ) , _mm256_mul_ps( e2Y , qY ) ) , _mm256_mul_ps( e2Z , qZ ) ) , invDet );
+		__m256 zero = _mm256_setzero_ps();
+		__m256 hit = _mm256_cmp_ps( det , zero , _CMP_NEQ_OQ );
+		hit = _mm256_and_ps( hit , _mm256_cmp_ps( laneU , zero , _CMP_GE_OQ ) );
+		hit = _mm256_and_ps( hit , _mm256_cmp_ps( laneV , zero , _CMP_GE_OQ ) );
+		hit = _mm256_and_ps( hit , _mm256_cmp_ps( _mm256_add_ps( laneU , laneV ) , _mm256_set1_ps( 1.0f ) , _CMP_LE_OQ ) );
+		hit = _mm256_and_ps( hit , _mm256_cmp_ps( laneT , zero , _CMP_GE_OQ ) );
+		hit = _mm256_and_ps( hit , _mm256_cmp_ps( laneT , _mm256_set1_ps( maxT ) , _CMP_LT_OQ ) );
+		hitMask = uint32_t( _mm256_movemask_ps( hit ) );
+		if( !hitMask )
+		{
+			return NONE;
+		}
+		_mm256_storeu_ps( aT , laneT );
+		_mm256_storeu_ps( aU , laneU );
+		_mm256_storeu_ps( aV , laneV );
+#else
+		for( uint32_t lane = 0; lane < WIDTH; lane++ )
+		{
+			float3 e1( aE1[ 0 ][ lane ] , aE1[ 1 ][ lane ] , aE1[ 2 ][ lane ] );
+			float3 e2( aE2[ 0 ][ lane ] , aE2[ 1 ][ lane ] , aE2[ 2 ][ lane ] );
+			float3 p = dir ^ e2;
+			float det = e1 * p;
+			if( det == 0.0f )
+			{
+				continue;
+			}
+			float invDet = 1.0f / det;
+			float3 s = pos - float3( aP0[ 0 ][ lane ] , aP0[ 1 ][ lane ] , aP0[ 2 ][ lane ] );
+			aU[ lane ] = s * p * invDet;
+			float3 q = s ^ e1;
+			aV[ lane ] = dir * q * invDet;
+			aT[ lane ] = e2 * q * invDet;
+			if( aU[ lane ] >= 0.0f && aV[ lane ] >= 0.0f && aU[ lane ] + aV[ lane ] <= 1.0f && aT[ lane ] >= 0.0f && aT[ lane ] < maxT )
+			{
+				hitMask |= 1u << lane;
+			}
+		}
+#endif
+		uint32_t bestLane = NONE;
+		for( uint32_t lane = 0; lane < WIDTH; lane++ )
+		{
+			if( ( hitMask >> lane & 1 ) && aT[ lane ] < maxT )
+			{
+				maxT = aT[ lane ];
+				bestLane = lane;
+			}
+		}
+		if( bestLane != NONE )
+		{
+			u = aU[ bestLane ];
+			v = aV[ bestLane ];
+		}
+		return bestLane;
+	}
+	// Packs the count faces of aFaceList in order into getBlockCount( count ) blocks
+	static void pack( Mesh const &mesh , uint32_t const *aFaceList , uint32_t count , TriangleBlock *aBlocks )
+	{
+		for( uint32_t first = 0; first < count; first += WIDTH )
+		{
+			TriangleBlock &block = aBlocks[ first / WIDTH ];
+			block.clear();
+			for( uint32_t lane = 0; lane < WIDTH && first + lane < count; lane++ )
+			{
+				uint32_t face = aFaceList[ first + lane ];
+				block.set( lane , face , mesh.aFaceRecords[ face ] );
+			}
+		}
+	}
+	static uint32_t getBlockCount( uint32_t faceCount )
+	{
+		return ( faceCount + WIDTH - 1 ) / WIDTH;
+	}
+};
+// Every face packed into blocks in face order, the SIMD replacement of a collide() loop
+struct TriangleScan
+{
+	Mesh const *pMesh = nullptr;
+	uint32_t meshVersion = 0;
+	std::vector< TriangleBlock > aBlocks;
+	bool isValid( Mesh const &mesh ) const
+	{
+		return pMesh == &mesh && meshVersion == mesh.version;
+	}
+	void update( Mesh const &mesh )
+	{
+		if( !isValid( mesh ) )
+		{
+			build( mesh );
+		}
+	}
+	void build( Mesh const &mesh )
+	{
+		pMesh = &mesh;
+		meshVersion = mesh.version;
+		int faceCount = int( mesh.getFaceCount() );
+		aBlocks.resize( TriangleBlock::getBlockCount( faceCount ) );
+		int blockCount = int( aBlocks.size() );
+#pragma omp parallel for
+		for( int block = 0; block < blockCount; block++ )
+		{
+			uint32_t aFaceList[ TriangleBlock::WIDTH ];
+			uint32_t first = uint32_t( block ) * TriangleBlock::WIDTH;
+			uint32_t count = std::min( uint32_t( TriangleBlock::WIDTH ) , uint32_t( faceCount ) - first );
+			for( uint32_t i = 0; i < count; i++ )
+			{
+				aFaceList[ i ] = first + i;
+			}
+			TriangleBlock::pack( mesh , aFaceList , count , &aBlocks[ block ] );
+		}
+	}
+	// Closest face hit by the ray pos + dir * t, t >= 0
+	bool pick( float3 const &pos , float3 const &dir , uint32_t &hitFace , float3 &hitPoint ) const
+	{
+		float bestT = FLT_MAX , u , v;
+		hitFace = Mesh::INVALID;
+		for( auto const &block : aBlocks )
+		{
+			uint32_t lane = block.intersect( pos , dir , bestT , u , v );
+			if( lane != TriangleBlock::NONE )
+			{
+				hitFace = block.aFaces[ lane ];
+			}
+		}
+		if( hitFace != Mesh::INVALID )
+		{
+			hitPoint = pos + dir * bestT;
+		}
+		return hitFace != Mesh::INVALID;
+	}
+};